@@ -0,0 +1,170 @@
+//
+//  catalog_bench.cpp
+//  PhotoList
+//
+//  Compares the contiguous Catalog with a std::list<PhotoData> holding the
+//  same synthetic games: heap bytes held, time to build, and time to traverse
+//  hot fields (sizes) and cold text (headline search).
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <new>
+#include <string>
+
+#include "Catalog.hpp"
+#include "PhotoData.hpp"
+
+// Every allocation carries its size in front so live heap bytes can be
+// tracked exactly, independent of the allocator.
+static size_t live_bytes = 0;
+
+void * operator new(size_t size) {
+  size_t * p = (size_t *)malloc(size + sizeof(std::max_align_t));
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  *p = size;
+  live_bytes += size;
+  return (char *)p + sizeof(std::max_align_t);
+}
+
+void operator delete(void * ptr) noexcept {
+  if (ptr == nullptr) {
+    return;
+  }
+  size_t * p = (size_t *)((char *)ptr - sizeof(std::max_align_t));
+  live_bytes -= *p;
+  free(p);
+}
+
+static const int cut_widths[] = {209, 320, 480, 640, 960, 1280, 1920};
+
+static PhotoData make_game(int n) {
+  char text[256];
+  PhotoData pd;
+  snprintf(text, sizeof(text), "Team %d rallies past Team %d in game %d", n % 30, (n + 7) % 30, n);
+  pd.headline = text;
+  snprintf(text, sizeof(text), "Slugger %d drives in three as the home side takes the series opener, game %d", n % 97, n);
+  pd.subhead = text;
+  for (const char * aspect : {"16:9", "4:3"}) {
+    for (int width : cut_widths) {
+      PhotoCut cut;
+      cut.aspect_ratio = aspect;
+      cut.width = width;
+      cut.height = aspect[0] == '1' ? width * 9 / 16 : width * 3 / 4;
+      snprintf(text, sizeof(text),
+               "https://img.mlbstatic.com/mlb-images/image/private/t_%s/t_w%d/mlb/g%08d.jpg",
+               aspect[0] == '1' ? "16x9" : "4x3", width, n);
+      cut.url = text;
+      pd.cuts.push_back(cut);
+    }
+  }
+  pd.url = pd.cuts[2].url;
+  pd.width = pd.cuts[2].width;
+  pd.height = pd.cuts[2].height;
+  pd.game.game_pk = 530000 + n;
+  snprintf(text, sizeof(text), "2018-%02d-%02d", 4 + n / 450 % 6, 1 + n / 15 % 28);
+  pd.game.date = text;
+  pd.game.time = pd.game.date + "T23:05:00Z";
+  pd.game.away_team = "Team " + std::to_string(n % 30);
+  pd.game.home_team = "Team " + std::to_string((n + 7) % 30);
+  pd.game.venue = "Park " + std::to_string((n + 7) % 30);
+  return pd;
+}
+
+typedef std::chrono::steady_clock Clock;
+
+static double ms_since(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static void report(const char * container, int games, const char * measure, double value, const char * unit) {
+  printf("%-8s %7d games  %-16s %12.3f %s\n", container, games, measure, value, unit);
+}
+
+static void bench(int games) {
+  const int traversals = 20;
+  const char * needle = "Team 7 ";
+  long checksum = 0;
+
+  // list
+  {
+    size_t before = live_bytes;
+    Clock::time_point start = Clock::now();
+    std::list<PhotoData> list;
+    for (int i = 0; i < games; i++) {
+      list.push_back(make_game(i));
+    }
+    report("list", games, "build", ms_since(start), "ms");
+    report("list", games, "heap", (live_bytes - before) / 1024.0, "KiB");
+
+    start = Clock::now();
+    for (int t = 0; t < traversals; t++) {
+      for (const PhotoData & pd : list) {
+        checksum += (long)pd.width * pd.height;
+      }
+    }
+    report("list", games, "sizes", ms_since(start) / traversals, "ms");
+
+    start = Clock::now();
+    for (int t = 0; t < traversals; t++) {
+      for (const PhotoData & pd : list) {
+        checksum += pd.headline.find(needle) != std::string::npos;
+      }
+    }
+    report("list", games, "search", ms_since(start) / traversals, "ms");
+  }
+
+  // catalog
+  {
+    size_t before = live_bytes;
+    Clock::time_point start = Clock::now();
+    Catalog catalog;
+    for (int i = 0; i < games; i++) {
+      catalog.push_back(make_game(i));
+    }
+    report("catalog", games, "build", ms_since(start), "ms");
+    report("catalog", games, "heap", (live_bytes - before) / 1024.0, "KiB");
+
+    start = Clock::now();
+    for (int t = 0; t < traversals; t++) {
+      for (size_t i = 0; i < catalog.size(); i++) {
+        checksum += (long)catalog.width(i) * catalog.height(i);
+      }
+    }
+    report("catalog", games, "sizes", ms_since(start) / traversals, "ms");
+
+    size_t needle_length = strlen(needle);
+    start = Clock::now();
+    for (int t = 0; t < traversals; t++) {
+      for (size_t i = 0; i < catalog.size(); i++) {
+        TextRef ref = catalog.headline_ref(i);
+        const char * text = catalog.text(ref);
+        checksum += std::search(text, text + ref.length, needle, needle + needle_length) != text + ref.length;
+      }
+    }
+    report("catalog", games, "search", ms_since(start) / traversals, "ms");
+  }
+
+  // keep the traversals from being optimized away
+  if (checksum == 42) {
+    printf("\n");
+  }
+}
+
+int main(int argc, const char * argv[]) {
+  if (argc > 1) {
+    bench(atoi(argv[1]));
+    return 0;
+  }
+  for (int games : {1000, 10000, 100000}) {
+    bench(games);
+  }
+  return 0;
+}
@@ -0,0 +1,332 @@
+//
+//  pipeline_bench.cpp
+//  PhotoList
+//
+//  Times the stages between a schedule arriving and a photo being ready to
+//  draw: parsing and filtering schedules, decoding JPEGs, scaling photos
+//  into boxes and rendering text. Each result is one line of
+//  whitespace-separated fields, so runs can be collected and compared over
+//  time:
+//
+//    benchmark case runs median_ms min_ms rate unit
+//
+//  Recorded schedules (.json) and photos (.jpg) named on the command line
+//  are timed alongside the synthetic ones. Run from the repository root,
+//  where the fonts and images are. Composing frames and scrolling are
+//  timed end to end by the real view instead, with PhotoList-bench
+//  --headless and bench/scroll.script (make bench runs both).
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SDL.h"
+#include "SDL_image.h"
+#include "SDL_ttf.h"
+
+#include "Catalog.hpp"
+#include "JsonFilter.hpp"
+#include "PhotoSizes.hpp"
+#include "Resource.hpp"
+#include "util.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+static const int cut_widths[] = {209, 320, 480, 640, 960, 1280, 1920};
+
+// The focused box as PhotoList draws it, on a 1920x1080 screen.
+static const int screen_w = 1920;
+static const int screen_h = 1080;
+static const int fbox_w = scale_fbox(box_width);
+static const int fbox_h = scale_fbox(box_height_for_width(box_width));
+
+// Each case runs at least min_runs times and for at least min_total_ms.
+static const int min_runs = 5;
+static const int max_runs = 100000;
+static const double min_total_ms = 250;
+
+static double ms_since(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static std::vector<double> time_runs(std::function<void()> run) {
+  std::vector<double> ms;
+  double total_ms = 0;
+  while ((int)ms.size() < max_runs && ((int)ms.size() < min_runs || total_ms < min_total_ms)) {
+    Clock::time_point start = Clock::now();
+    run();
+    ms.push_back(ms_since(start));
+    total_ms += ms.back();
+  }
+  return ms;
+}
+
+// work is how much one run does, in unit, reported per second at the median.
+static void report(const char * benchmark, const std::string & variant,
+                   std::vector<double> ms, double work, const char * unit) {
+  std::sort(ms.begin(), ms.end());
+  double median_ms = ms[ms.size() / 2];
+  printf("%-18s %-30s %6zu %10.4f %10.4f %12.2f %s\n",
+         benchmark, variant.c_str(), ms.size(), median_ms, ms[0],
+         median_ms > 0 ? work / (median_ms / 1000) : 0, unit);
+  fflush(stdout);
+}
+
+static bool ends_with(const std::string & s, const char * suffix) {
+  size_t n = strlen(suffix);
+  return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+static std::string base_name(const std::string & path) {
+  return path.substr(path.rfind('/') + 1);
+}
+
+static std::string read_file(const std::string & filename) {
+  std::ifstream in(filename, std::ios::binary);
+  if (!in) {
+    error(("couldn't read " + filename).c_str());
+  }
+  std::stringstream contents;
+  contents << in.rdbuf();
+  return contents.str();
+}
+
+// A schedule shaped like statsapi's, hydrated as PhotoList asks for, with
+// every photo in the usual two aspect ratios and seven widths.
+static std::string synthetic_schedule(int games) {
+  std::string json = "{\"totalGames\":" + std::to_string(games)
+    + ",\"dates\":[{\"date\":\"2018-06-10\",\"totalGames\":" + std::to_string(games) + ",\"games\":[";
+  char text[512];
+  for (int n = 0; n < games; n++) {
+    snprintf(text, sizeof(text),
+             "%s{\"gamePk\":%d,\"gameType\":\"R\",\"season\":\"2018\","
+             "\"gameDate\":\"2018-06-10T%02d:05:00Z\",\"officialDate\":\"2018-06-10\","
+             "\"status\":{\"abstractGameState\":\"Final\",\"detailedState\":\"Final\"},"
+             "\"teams\":{\"away\":{\"score\":%d,\"team\":{\"id\":%d,\"name\":\"Team %d\"}},"
+             "\"home\":{\"score\":%d,\"team\":{\"id\":%d,\"name\":\"Team %d\"}}},"
+             "\"venue\":{\"id\":%d,\"name\":\"Park %d\"},"
+             "\"decisions\":{\"winner\":{\"id\":%d,\"fullName\":\"Pitcher %d\"},"
+             "\"loser\":{\"id\":%d,\"fullName\":\"Pitcher %d\"}},",
+             n == 0 ? "" : ",", 530000 + n, 16 + n % 8,
+             n % 9, 100 + n % 30, n % 30, (n + 3) % 9, 100 + (n + 7) % 30, (n + 7) % 30,
+             (n + 7) % 30, (n + 7) % 30, n % 97, n % 97, (n + 13) % 97, (n + 13) % 97);
+    json += text;
+    snprintf(text, sizeof(text),
+             "\"content\":{\"editorial\":{\"recap\":{\"mlb\":{"
+             "\"headline\":\"Team %d rallies past Team %d in game %d\","
+             "\"subhead\":\"Slugger %d drives in three as the home side takes the series opener\","
+             "\"image\":{\"title\":\"Recap %d\",\"cuts\":[",
+             n % 30, (n + 7) % 30, n, n % 97, n);
+    json += text;
+    bool first = true;
+    for (const char * aspect : {"16:9", "4:3"}) {
+      for (int width : cut_widths) {
+        int height = aspect[0] == '1' ? width * 9 / 16 : width * 3 / 4;
+        snprintf(text, sizeof(text),
+                 "%s{\"aspectRatio\":\"%s\",\"width\":%d,\"height\":%d,"
+                 "\"src\":\"https://img.mlbstatic.com/mlb-images/image/private/t_%s/t_w%d/mlb/g%08d.jpg\"}",
+                 first ? "" : ",", aspect, width, height,
+                 aspect[0] == '1' ? "16x9" : "4x3", width, n);
+        json += text;
+        first = false;
+      }
+    }
+    json += "]}}}}}}";
+  }
+  return json + "]}]}";
+}
+
+static void bench_parse(const std::string & variant, const std::string & json) {
+  size_t photos = 0;
+  std::vector<double> ms = time_runs([&] {
+      Catalog catalog;
+      parse_and_filter(json.c_str(), aspect_ratio_string, minimum_width, catalog);
+      photos = catalog.size();
+    });
+  report("parse_and_filter", variant, ms, json.size() / 1e6, "MB/s");
+  report("parse_and_filter", variant, ms, photos, "games/s");
+}
+
+static SDL_Surface * decode(const std::string & jpeg) {
+  SDL_Surface * image = IMG_Load_RW(SDL_RWFromConstMem(jpeg.data(), jpeg.size()), 1);
+  if (image == nullptr) {
+    error("couldn't decode jpeg");
+  }
+  return image;
+}
+
+static void bench_decode(const std::string & variant, const std::string & jpeg) {
+  SDL_Surface * probe = decode(jpeg);
+  double megapixels = probe->w * probe->h / 1e6;
+  SDL_FreeSurface(probe);
+  std::vector<double> ms = time_runs([&] {
+      SDL_FreeSurface(decode(jpeg));
+    });
+  report("jpeg_decode", variant, ms, megapixels, "Mpx/s");
+}
+
+// The photo re-encoded at a cut's width, or empty if this SDL_image can't
+// write JPEGs.
+static std::string encode_at_width(SDL_Surface * photo, int width) {
+  SDL_Surface * scaled = SDL_CreateRGBSurfaceWithFormat(0, width, width * photo->h / photo->w, 24,
+                                                        SDL_PIXELFORMAT_RGB24);
+  if (scaled == nullptr || SDL_BlitScaled(photo, NULL, scaled, NULL) != 0) {
+    error("couldn't scale photo for encoding");
+  }
+  std::vector<char> buffer(4 * 1024 * 1024 + scaled->pitch * scaled->h);
+  SDL_RWops * out = SDL_RWFromMem(buffer.data(), buffer.size());
+  std::string jpeg;
+  if (IMG_SaveJPG_RW(scaled, out, 0, 85) == 0) {
+    jpeg.assign(buffer.data(), SDL_RWtell(out));
+  }
+  SDL_RWclose(out);
+  SDL_FreeSurface(scaled);
+  return jpeg;
+}
+
+static SDL_Surface * create_surface(int w, int h, Uint32 format) {
+  SDL_Surface * surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, SDL_BITSPERPIXEL(format), format);
+  if (surface == nullptr) {
+    error("couldn't create surface");
+  }
+  return surface;
+}
+
+// What PLView::fit does to each photo once: convert to the screen's format
+// and stretch to the box.
+static SDL_Surface * fit(SDL_Surface * image, const SDL_PixelFormat * format, int w, int h) {
+  SDL_Surface * converted = SDL_ConvertSurface(image, format, 0);
+  SDL_Surface * fitted = create_surface(w, h, format->format);
+  if (converted == nullptr || SDL_SoftStretch(converted, NULL, fitted, NULL) != 0) {
+    error("couldn't fit image");
+  }
+  SDL_FreeSurface(converted);
+  return fitted;
+}
+
+// Ways of getting a decoded photo into the focused box on screen.
+static void bench_scale(SDL_Surface * photo, SDL_Surface * screen) {
+  double megapixels = fbox_w * fbox_h / 1e6;
+  SDL_Rect box = {screen_w / 2 - fbox_w / 2, 200, fbox_w, fbox_h};
+
+  // every frame, straight from the decoder's format
+  report("scale", "blit_scaled-decoded", time_runs([&] {
+        SDL_Rect rect = box;
+        SDL_BlitScaled(photo, NULL, screen, &rect);
+      }), megapixels, "Mpx/s");
+
+  // every frame, converted to the screen's format beforehand
+  SDL_Surface * converted = SDL_ConvertSurface(photo, screen->format, 0);
+  report("scale", "blit_scaled-converted", time_runs([&] {
+        SDL_Rect rect = box;
+        SDL_BlitScaled(converted, NULL, screen, &rect);
+      }), megapixels, "Mpx/s");
+  report("scale", "soft_stretch-converted", time_runs([&] {
+        SDL_Rect rect = box;
+        SDL_SoftStretch(converted, NULL, screen, &rect);
+      }), megapixels, "Mpx/s");
+
+  // once per photo, then a plain copy every frame, as PhotoList does
+  report("scale", "fit-once", time_runs([&] {
+        SDL_FreeSurface(fit(photo, screen->format, fbox_w, fbox_h));
+      }), megapixels, "Mpx/s");
+  SDL_Surface * fitted = fit(photo, screen->format, fbox_w, fbox_h);
+  report("scale", "blit-prefitted", time_runs([&] {
+        SDL_Rect rect = box;
+        SDL_BlitSurface(fitted, NULL, screen, &rect);
+      }), megapixels, "Mpx/s");
+  report("scale", "blit_scaled-prefitted", time_runs([&] {
+        SDL_Rect rect = box;
+        SDL_BlitScaled(fitted, NULL, screen, &rect);
+      }), megapixels, "Mpx/s");
+  SDL_FreeSurface(fitted);
+  SDL_FreeSurface(converted);
+}
+
+static void bench_text() {
+  TTF_Init();
+  Resource font_file("fonts/LiberationSans-Regular.ttf");
+  SDL_Color white = {255, 255, 255, 255};
+  const char * headline = "Team 12 rallies past Team 19 in game 530412";
+  const char * subhead = "Slugger 41 drives in three as the home side takes the series opener";
+  for (int point_size : {48, 24}) {
+    TTF_Font * font = font_file.open_font(point_size);
+    const char * text = point_size == 48 ? headline : subhead;
+    std::string variant = std::to_string(point_size) + "pt";
+    report("text", "solid-" + variant, time_runs([&] {
+          SDL_FreeSurface(TTF_RenderUTF8_Solid(font, text, white));
+        }), 1, "lines/s");
+    report("text", "blended-" + variant, time_runs([&] {
+          SDL_FreeSurface(TTF_RenderUTF8_Blended(font, text, white));
+        }), 1, "lines/s");
+    TTF_CloseFont(font);
+  }
+  TTF_Quit();
+}
+
+int main(int argc, const char * argv[]) {
+  std::vector<std::string> schedules;
+  std::vector<std::string> photos;
+  for (int i = 1; i < argc; i++) {
+    if (ends_with(argv[i], ".json")) {
+      schedules.push_back(argv[i]);
+    } else if (ends_with(argv[i], ".jpg") || ends_with(argv[i], ".jpeg")) {
+      photos.push_back(argv[i]);
+    } else {
+      fprintf(stderr, "usage: pipeline_bench [SCHEDULE.json | PHOTO.jpg]...\n");
+      return 2;
+    }
+  }
+  if (SDL_Init(0) != 0 || IMG_Init(IMG_INIT_JPG) != IMG_INIT_JPG) {
+    error("couldn't initialize SDL");
+  }
+  printf("# benchmark        case                             runs  median_ms     min_ms         rate unit\n");
+
+  for (int games : {15, 1000, 10000}) {
+    bench_parse("synthetic-" + std::to_string(games) + "-games", synthetic_schedule(games));
+  }
+  for (const std::string & schedule : schedules) {
+    bench_parse(base_name(schedule), read_file(schedule));
+  }
+
+  std::string background_jpeg = read_file("images/1.jpg");
+  bench_decode("background-1920", background_jpeg);
+  SDL_Surface * background = decode(background_jpeg);
+  std::vector<std::pair<std::string, std::string>> cuts;
+  for (int width : {480, 960, 1280}) {
+    std::string jpeg = encode_at_width(background, width);
+    if (jpeg.empty()) {
+      warning("this SDL_image can't encode JPEGs; timing recorded photos only");
+      break;
+    }
+    cuts.push_back(std::make_pair("cut-" + std::to_string(width), jpeg));
+  }
+  for (const std::string & photo : photos) {
+    cuts.push_back(std::make_pair(base_name(photo), read_file(photo)));
+  }
+  for (auto & cut : cuts) {
+    bench_decode(cut.first, cut.second);
+  }
+
+  // the focused box's photo is the smallest cut at least minimum_width wide
+  std::string box_jpeg = cuts.empty() ? background_jpeg : cuts[0].second;
+  SDL_Surface * screen = create_surface(screen_w, screen_h, SDL_PIXELFORMAT_RGB888);
+  SDL_Surface * box_photo = decode(box_jpeg);
+  bench_scale(box_photo, screen);
+  SDL_FreeSurface(box_photo);
+
+  bench_text();
+
+  SDL_FreeSurface(screen);
+  SDL_FreeSurface(background);
+  IMG_Quit();
+  SDL_Quit();
+  return 0;
+}
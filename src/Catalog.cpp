@@ -0,0 +1,277 @@
+#include <utility>
+
+#include "Catalog.hpp"
+#include "util.hpp"
+
+TextRef Catalog::add_text(const char * data, size_t length) {
+  TextRef ref;
+  ref.offset = _text.size();
+  ref.length = length;
+  _text.append(data, length);
+  return ref;
+}
+
+// Only a handful of aspect ratios appear in a feed, so a linear scan beats
+// hashing and every cut shares one copy of each.
+TextRef Catalog::intern_aspect_ratio(const std::string & aspect_ratio) {
+  for (TextRef ref : _aspect_ratios) {
+    if (text_equals(ref, aspect_ratio)) {
+      return ref;
+    }
+  }
+  TextRef ref = add_text(aspect_ratio);
+  _aspect_ratios.push_back(ref);
+  return ref;
+}
+
+void Catalog::reserve(size_t photos, size_t cuts, size_t text_bytes) {
+  _url.reserve(photos);
+  _width.reserve(photos);
+  _height.reserve(photos);
+  _state.reserve(photos);
+  _headline.reserve(photos);
+  _subhead.reserve(photos);
+  _first_cut.reserve(photos);
+  _cut_count.reserve(photos);
+  _cuts.reserve(cuts);
+  _game_pk.reserve(photos);
+  _game_date.reserve(photos);
+  _game_time.reserve(photos);
+  _away_team.reserve(photos);
+  _home_team.reserve(photos);
+  _venue.reserve(photos);
+  _text.reserve(text_bytes);
+}
+
+void Catalog::clear() {
+  _url.clear();
+  _width.clear();
+  _height.clear();
+  _state.clear();
+  _headline.clear();
+  _subhead.clear();
+  _first_cut.clear();
+  _cut_count.clear();
+  _cuts.clear();
+  _game_pk.clear();
+  _game_date.clear();
+  _game_time.clear();
+  _away_team.clear();
+  _home_team.clear();
+  _venue.clear();
+  _text.clear();
+  _aspect_ratios.clear();
+}
+
+size_t Catalog::add_photo(const std::string & headline, const std::string & subhead) {
+  TextRef none = {(uint32_t)_text.size(), 0};
+  _url.push_back(none);
+  _width.push_back(0);
+  _height.push_back(0);
+  _state.push_back(photo_unloaded);
+  _headline.push_back(add_text(headline));
+  _subhead.push_back(add_text(subhead));
+  _first_cut.push_back(_cuts.size());
+  _cut_count.push_back(0);
+  _game_pk.push_back(0);
+  _game_date.push_back(none);
+  _game_time.push_back(none);
+  _away_team.push_back(none);
+  _home_team.push_back(none);
+  _venue.push_back(none);
+  return size() - 1;
+}
+
+void Catalog::add_cut(const std::string & aspect_ratio,
+                      const std::string & url,
+                      int width,
+                      int height) {
+  if (empty()) {
+    error("Catalog::add_cut: no photo to add cut to");
+  }
+  CatalogCut cut;
+  cut.aspect_ratio = intern_aspect_ratio(aspect_ratio);
+  cut.url = add_text(url);
+  cut.width = width;
+  cut.height = height;
+  _cuts.push_back(cut);
+  _cut_count.back()++;
+}
+
+// The selected url refers to the cut's own copy of the text.
+void Catalog::set_selected_cut(size_t i, size_t j) {
+  const CatalogCut & c = cut(i, j);
+  _url[i] = c.url;
+  _width[i] = c.width;
+  _height[i] = c.height;
+}
+
+void Catalog::set_game(size_t i, const GameInfo & game) {
+  _game_pk[i] = game.game_pk;
+  _game_date[i] = add_text(game.date);
+  _game_time[i] = add_text(game.time);
+  _away_team[i] = add_text(game.away_team);
+  _home_team[i] = add_text(game.home_team);
+  _venue[i] = add_text(game.venue);
+}
+
+size_t Catalog::push_back(const PhotoData & pd) {
+  size_t i = add_photo(pd.headline, pd.subhead);
+  set_game(i, pd.game);
+  bool selected = false;
+  for (size_t j = 0; j < pd.cuts.size(); j++) {
+    const PhotoCut & pc = pd.cuts[j];
+    add_cut(pc.aspect_ratio, pc.url, pc.width, pc.height);
+    if (!selected && pc.url == pd.url && pc.width == pd.width && pc.height == pd.height) {
+      set_selected_cut(i, j);
+      selected = true;
+    }
+  }
+  if (!selected) {
+    _url[i] = add_text(pd.url);
+    _width[i] = pd.width;
+    _height[i] = pd.height;
+  }
+  return i;
+}
+
+void Catalog::append(const Catalog & other, size_t begin, size_t end) {
+  for (size_t i = begin; i < end; i++) {
+    TextRef headline = other._headline[i];
+    TextRef subhead = other._subhead[i];
+    size_t k = size();
+    _url.push_back(TextRef{(uint32_t)_text.size(), 0});
+    _width.push_back(other._width[i]);
+    _height.push_back(other._height[i]);
+    _state.push_back(other._state[i]);
+    _headline.push_back(add_text(other.text(headline), headline.length));
+    _subhead.push_back(add_text(other.text(subhead), subhead.length));
+    _first_cut.push_back(_cuts.size());
+    _cut_count.push_back(0);
+    _game_pk.push_back(other._game_pk[i]);
+    _game_date.push_back(add_text(other.text(other._game_date[i]), other._game_date[i].length));
+    _game_time.push_back(add_text(other.text(other._game_time[i]), other._game_time[i].length));
+    _away_team.push_back(add_text(other.text(other._away_team[i]), other._away_team[i].length));
+    _home_team.push_back(add_text(other.text(other._home_team[i]), other._home_team[i].length));
+    _venue.push_back(add_text(other.text(other._venue[i]), other._venue[i].length));
+
+    bool selected = false;
+    for (size_t j = 0; j < other.cut_count(i); j++) {
+      const CatalogCut & c = other.cut(i, j);
+      CatalogCut copy = c;
+      copy.aspect_ratio = intern_aspect_ratio(other.str(c.aspect_ratio));
+      copy.url = add_text(other.text(c.url), c.url.length);
+      _cuts.push_back(copy);
+      _cut_count.back()++;
+      // keep sharing the url text with the selected cut
+      if (!selected && c.url.offset == other._url[i].offset
+          && c.url.length == other._url[i].length) {
+        _url[k] = copy.url;
+        selected = true;
+      }
+    }
+    if (!selected) {
+      _url[k] = add_text(other.text(other._url[i]), other._url[i].length);
+    }
+  }
+}
+
+void Catalog::erase(size_t begin, size_t end) {
+  Catalog kept;
+  kept.append(*this, 0, begin);
+  kept.append(*this, end, size());
+  *this = std::move(kept);
+}
+
+GameInfo Catalog::game(size_t i) const {
+  GameInfo game;
+  game.game_pk = _game_pk[i];
+  game.date = str(_game_date[i]);
+  game.time = str(_game_time[i]);
+  game.away_team = str(_away_team[i]);
+  game.home_team = str(_home_team[i]);
+  game.venue = str(_venue[i]);
+  return game;
+}
+
+PhotoData Catalog::photo(size_t i) const {
+  PhotoData pd;
+  pd.headline = headline(i);
+  pd.subhead = subhead(i);
+  pd.url = url(i);
+  pd.width = width(i);
+  pd.height = height(i);
+  for (size_t j = 0; j < cut_count(i); j++) {
+    const CatalogCut & c = cut(i, j);
+    PhotoCut pc;
+    pc.aspect_ratio = str(c.aspect_ratio);
+    pc.url = str(c.url);
+    pc.width = c.width;
+    pc.height = c.height;
+    pd.cuts.push_back(pc);
+  }
+  pd.game = game(i);
+  return pd;
+}
+
+size_t Catalog::memory_usage() const {
+  return _url.capacity() * sizeof(TextRef)
+    + _width.capacity() * sizeof(int32_t)
+    + _height.capacity() * sizeof(int32_t)
+    + _state.capacity() * sizeof(PhotoState)
+    + _headline.capacity() * sizeof(TextRef)
+    + _subhead.capacity() * sizeof(TextRef)
+    + _first_cut.capacity() * sizeof(uint32_t)
+    + _cut_count.capacity() * sizeof(uint32_t)
+    + _cuts.capacity() * sizeof(CatalogCut)
+    + _game_pk.capacity() * sizeof(int64_t)
+    + (_game_date.capacity() + _game_time.capacity() + _away_team.capacity()
+       + _home_team.capacity() + _venue.capacity()) * sizeof(TextRef)
+    + _text.capacity()
+    + _aspect_ratios.capacity() * sizeof(TextRef);
+}
+
+static bool same_text(const Catalog & a, TextRef ra, const Catalog & b, TextRef rb) {
+  return ra.length == rb.length
+    && std::char_traits<char>::compare(a.text(ra), b.text(rb), ra.length) == 0;
+}
+
+bool same_photo(const Catalog & a, size_t i, const Catalog & b, size_t j) {
+  if (a.width(i) != b.width(j)
+      || a.height(i) != b.height(j)
+      || a.cut_count(i) != b.cut_count(j)
+      || !same_text(a, a.url_ref(i), b, b.url_ref(j))
+      || !same_text(a, a.headline_ref(i), b, b.headline_ref(j))
+      || !same_text(a, a.subhead_ref(i), b, b.subhead_ref(j))
+      || a.game_pk(i) != b.game_pk(j)
+      || !same_text(a, a.game_date_ref(i), b, b.game_date_ref(j))
+      || !same_text(a, a.game_time_ref(i), b, b.game_time_ref(j))
+      || !same_text(a, a.away_team_ref(i), b, b.away_team_ref(j))
+      || !same_text(a, a.home_team_ref(i), b, b.home_team_ref(j))
+      || !same_text(a, a.venue_ref(i), b, b.venue_ref(j))) {
+    return false;
+  }
+  for (size_t k = 0; k < a.cut_count(i); k++) {
+    const CatalogCut & ca = a.cut(i, k);
+    const CatalogCut & cb = b.cut(j, k);
+    if (ca.width != cb.width
+        || ca.height != cb.height
+        || !same_text(a, ca.aspect_ratio, b, cb.aspect_ratio)
+        || !same_text(a, ca.url, b, cb.url)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool operator==(const Catalog & a, const Catalog & b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); i++) {
+    if (!same_photo(a, i, b, i)) {
+      return false;
+    }
+  }
+  return true;
+}
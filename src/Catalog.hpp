@@ -0,0 +1,128 @@
+#ifndef CATALOG_HPP
+#define CATALOG_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "PhotoData.hpp"
+
+// Location of a string in a Catalog's text arena.
+struct TextRef {
+  uint32_t offset;
+  uint32_t length;
+};
+
+// One cut of a photo, with its text in the catalog's arena.
+struct CatalogCut {
+  TextRef aspect_ratio;
+  TextRef url;
+  int32_t width;
+  int32_t height;
+};
+
+enum PhotoState : uint8_t {
+  photo_unloaded,
+  photo_loading,
+  photo_loaded
+};
+
+// Contiguous store of filtered photos. The fields read on every traversal
+// (selected url, size, load state) live in parallel arrays, apart from the
+// headline, subhead, cuts and game details, and all text lives in one arena.
+// Photos are addressed by index.
+class Catalog {
+private:
+  // hot fields
+  std::vector<TextRef> _url;
+  std::vector<int32_t> _width;
+  std::vector<int32_t> _height;
+  std::vector<PhotoState> _state;
+
+  // cold fields
+  std::vector<TextRef> _headline;
+  std::vector<TextRef> _subhead;
+  std::vector<uint32_t> _first_cut;
+  std::vector<uint32_t> _cut_count;
+  std::vector<CatalogCut> _cuts;
+  std::vector<int64_t> _game_pk;
+  std::vector<TextRef> _game_date;
+  std::vector<TextRef> _game_time;
+  std::vector<TextRef> _away_team;
+  std::vector<TextRef> _home_team;
+  std::vector<TextRef> _venue;
+
+  std::string _text;
+  std::vector<TextRef> _aspect_ratios;  // distinct aspect ratios seen, shared by cuts
+
+  TextRef add_text(const std::string & s) { return add_text(s.data(), s.size()); }
+  TextRef add_text(const char * data, size_t length);
+  TextRef intern_aspect_ratio(const std::string & aspect_ratio);
+
+  friend class CatalogCache;
+
+public:
+  size_t size() const { return _width.size(); }
+  bool empty() const { return _width.empty(); }
+  void reserve(size_t photos, size_t cuts, size_t text_bytes);
+  void clear();
+
+  // Appends a photo with no cuts and returns its index. Cuts are added to the
+  // last photo with add_cut, then one is chosen with set_selected_cut.
+  size_t add_photo(const std::string & headline, const std::string & subhead);
+  void add_cut(const std::string & aspect_ratio, const std::string & url, int width, int height);
+  void set_selected_cut(size_t i, size_t cut);
+  void set_game(size_t i, const GameInfo & game);
+  size_t push_back(const PhotoData & pd);
+
+  // Appends photos [begin, end) of other, copying their text into this
+  // catalog's arena.
+  void append(const Catalog & other, size_t begin, size_t end);
+  void append(const Catalog & other) { append(other, 0, other.size()); }
+
+  // Removes photos [begin, end). The arena is compacted, so this costs a
+  // copy of the photos that remain.
+  void erase(size_t begin, size_t end);
+
+  TextRef url_ref(size_t i) const { return _url[i]; }
+  int width(size_t i) const { return _width[i]; }
+  int height(size_t i) const { return _height[i]; }
+  PhotoState state(size_t i) const { return _state[i]; }
+  void set_state(size_t i, PhotoState state) { _state[i] = state; }
+
+  TextRef headline_ref(size_t i) const { return _headline[i]; }
+  TextRef subhead_ref(size_t i) const { return _subhead[i]; }
+  size_t cut_count(size_t i) const { return _cut_count[i]; }
+  const CatalogCut & cut(size_t i, size_t j) const { return _cuts[_first_cut[i] + j]; }
+  int64_t game_pk(size_t i) const { return _game_pk[i]; }
+  TextRef game_date_ref(size_t i) const { return _game_date[i]; }
+  TextRef game_time_ref(size_t i) const { return _game_time[i]; }
+  TextRef away_team_ref(size_t i) const { return _away_team[i]; }
+  TextRef home_team_ref(size_t i) const { return _home_team[i]; }
+  TextRef venue_ref(size_t i) const { return _venue[i]; }
+
+  // Text in the arena is not NUL-terminated.
+  const char * text(TextRef ref) const { return _text.data() + ref.offset; }
+  std::string str(TextRef ref) const { return std::string(text(ref), ref.length); }
+  bool text_equals(TextRef ref, const std::string & s) const {
+    return ref.length == s.size() && _text.compare(ref.offset, ref.length, s) == 0;
+  }
+
+  std::string url(size_t i) const { return str(_url[i]); }
+  std::string headline(size_t i) const { return str(_headline[i]); }
+  std::string subhead(size_t i) const { return str(_subhead[i]); }
+  GameInfo game(size_t i) const;
+  PhotoData photo(size_t i) const;
+
+  // Bytes reserved by the catalog's arrays and arena.
+  size_t memory_usage() const;
+};
+
+// Photo i of a and photo j of b have the same text, cuts and game, ignoring
+// load state.
+bool same_photo(const Catalog & a, size_t i, const Catalog & b, size_t j);
+
+// Same photos with the same text, cuts and games, ignoring load state.
+bool operator==(const Catalog & a, const Catalog & b);
+
+#endif
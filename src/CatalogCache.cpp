@@ -0,0 +1,203 @@
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "CatalogCache.hpp"
+#include "MappedFile.hpp"
+
+static const char * cache_directory = "cache";
+static const char catalog_magic[8] = {'P', 'L', 'C', 'A', 'T', 'L', 'G', '\0'};
+// Bump whenever the layout below changes; older files are then ignored.
+static const uint32_t catalog_version = 3;
+
+struct CatalogHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t photo_count;
+  uint32_t cut_count;
+  uint32_t strings_size;
+  TextRef key;
+};
+
+struct CachedPhoto {
+  int64_t game_pk;
+  TextRef headline;
+  TextRef subhead;
+  TextRef url;
+  int32_t width;
+  int32_t height;
+  uint32_t first_cut;
+  uint32_t cut_count;
+  TextRef game_date;
+  TextRef game_time;
+  TextRef away_team;
+  TextRef home_team;
+  TextRef venue;
+};
+
+struct CachedCut {
+  TextRef aspect_ratio;
+  TextRef url;
+  int32_t width;
+  int32_t height;
+};
+
+static uint64_t fnv1a(const std::string & s) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : s) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+CatalogCache::CatalogCache(std::string feed_url,
+                           std::string aspect_ratio,
+                           int minimum_width) {
+  _key = feed_url + '\n' + aspect_ratio + '\n' + std::to_string(minimum_width);
+  char name[64];
+  snprintf(name, sizeof(name), "/catalog-%016llx.bin", (unsigned long long)fnv1a(_key));
+  _path = cache_directory + std::string(name);
+}
+
+void CatalogCache::save(const Catalog & games) const {
+  std::string strings = games._text;
+  std::vector<CachedPhoto> photos(games.size());
+  for (size_t i = 0; i < games.size(); i++) {
+    CachedPhoto & photo = photos[i];
+    photo.headline = games._headline[i];
+    photo.subhead = games._subhead[i];
+    photo.url = games._url[i];
+    photo.width = games._width[i];
+    photo.height = games._height[i];
+    photo.first_cut = games._first_cut[i];
+    photo.cut_count = games._cut_count[i];
+    photo.game_pk = games._game_pk[i];
+    photo.game_date = games._game_date[i];
+    photo.game_time = games._game_time[i];
+    photo.away_team = games._away_team[i];
+    photo.home_team = games._home_team[i];
+    photo.venue = games._venue[i];
+  }
+
+  CatalogHeader header;
+  memcpy(header.magic, catalog_magic, sizeof(header.magic));
+  header.version = catalog_version;
+  header.photo_count = photos.size();
+  header.cut_count = games._cuts.size();
+  header.key.offset = strings.size();
+  header.key.length = _key.size();
+  strings += _key;
+  header.strings_size = strings.size();
+
+  if (mkdir(cache_directory, 0755) != 0 && errno != EEXIST) {
+    warning("couldn't create catalog cache directory");
+    return;
+  }
+  // write to the side and rename, so a reader never maps a partial file
+  std::string tmp_path = _path + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    out.write((const char *)&header, sizeof(header));
+    out.write((const char *)photos.data(), photos.size() * sizeof(CachedPhoto));
+    static_assert(sizeof(CachedCut) == sizeof(CatalogCut), "cut records must match");
+    out.write((const char *)games._cuts.data(), games._cuts.size() * sizeof(CatalogCut));
+    out.write(strings.data(), strings.size());
+    if (!out) {
+      warning("couldn't write catalog cache");
+      return;
+    }
+  }
+  if (rename(tmp_path.c_str(), _path.c_str()) != 0) {
+    warning("couldn't replace catalog cache");
+  }
+}
+
+static bool string_in_bounds(TextRef ref, uint32_t strings_size) {
+  return ref.offset <= strings_size && ref.length <= strings_size - ref.offset;
+}
+
+// The arrays and arena are filled wholesale from the mapping; only bounds are
+// checked per record.
+bool CatalogCache::load(Catalog & games) const {
+  MappedFile file(_path);
+  if (!file.is_open() || file.size() < sizeof(CatalogHeader)) {
+    return false;
+  }
+  const CatalogHeader * header = (const CatalogHeader *)file.data();
+  if (memcmp(header->magic, catalog_magic, sizeof(catalog_magic)) != 0
+      || header->version != catalog_version) {
+    return false;
+  }
+  size_t expected_size = sizeof(CatalogHeader)
+    + (size_t)header->photo_count * sizeof(CachedPhoto)
+    + (size_t)header->cut_count * sizeof(CachedCut)
+    + header->strings_size;
+  if (file.size() != expected_size) {
+    return false;
+  }
+
+  const CachedPhoto * photos = (const CachedPhoto *)(header + 1);
+  const CachedCut * cuts = (const CachedCut *)(photos + header->photo_count);
+  const char * strings = (const char *)(cuts + header->cut_count);
+
+  // a hash collision in the file name must not return another feed's games
+  if (!string_in_bounds(header->key, header->strings_size)
+      || std::string(strings + header->key.offset, header->key.length) != _key) {
+    return false;
+  }
+
+  Catalog loaded;
+  loaded.reserve(header->photo_count, header->cut_count, header->key.offset);
+  loaded._text.assign(strings, header->key.offset);
+  uint32_t text_size = loaded._text.size();
+  for (uint32_t j = 0; j < header->cut_count; j++) {
+    if (!string_in_bounds(cuts[j].aspect_ratio, text_size)
+        || !string_in_bounds(cuts[j].url, text_size)) {
+      return false;
+    }
+    CatalogCut cut;
+    cut.aspect_ratio = cuts[j].aspect_ratio;
+    cut.url = cuts[j].url;
+    cut.width = cuts[j].width;
+    cut.height = cuts[j].height;
+    loaded._cuts.push_back(cut);
+  }
+  for (uint32_t i = 0; i < header->photo_count; i++) {
+    const CachedPhoto & photo = photos[i];
+    if (!string_in_bounds(photo.headline, text_size)
+        || !string_in_bounds(photo.subhead, text_size)
+        || !string_in_bounds(photo.url, text_size)
+        || !string_in_bounds(photo.game_date, text_size)
+        || !string_in_bounds(photo.game_time, text_size)
+        || !string_in_bounds(photo.away_team, text_size)
+        || !string_in_bounds(photo.home_team, text_size)
+        || !string_in_bounds(photo.venue, text_size)
+        || photo.first_cut > header->cut_count
+        || photo.cut_count > header->cut_count - photo.first_cut) {
+      return false;
+    }
+    loaded._headline.push_back(photo.headline);
+    loaded._subhead.push_back(photo.subhead);
+    loaded._url.push_back(photo.url);
+    loaded._width.push_back(photo.width);
+    loaded._height.push_back(photo.height);
+    loaded._state.push_back(photo_unloaded);
+    loaded._first_cut.push_back(photo.first_cut);
+    loaded._cut_count.push_back(photo.cut_count);
+    loaded._game_pk.push_back(photo.game_pk);
+    loaded._game_date.push_back(photo.game_date);
+    loaded._game_time.push_back(photo.game_time);
+    loaded._away_team.push_back(photo.away_team);
+    loaded._home_team.push_back(photo.home_team);
+    loaded._venue.push_back(photo.venue);
+  }
+  games = std::move(loaded);
+  return true;
+}
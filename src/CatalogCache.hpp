@@ -0,0 +1,32 @@
+#ifndef CATALOG_CACHE_HPP
+#define CATALOG_CACHE_HPP
+
+#include <string>
+
+#include "Catalog.hpp"
+#include "util.hpp"
+
+// On-disk copy of a filtered catalog, so startup can show the catalog without
+// waiting for the fetch, parse and filter cycle. One file per combination of
+// feed url and filter parameters. The file is a fixed-layout header followed
+// by fixed-size photo and cut records and the catalog's text arena, so it can
+// be used straight out of a read-only mapping.
+class CatalogCache : Uncopyable {
+private:
+  std::string _key;
+  std::string _path;
+
+public:
+  CatalogCache(std::string feed_url, std::string aspect_ratio, int minimum_width);
+
+  const std::string & path() const { return _path; }
+
+  // Fills games from the cache file. Returns false, leaving games untouched,
+  // if there is no usable file for this key.
+  bool load(Catalog & games) const;
+
+  // Replaces the cache file. Failures are reported but not fatal.
+  void save(const Catalog & games) const;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#include <cstdio>
+
+#include "Date.hpp"
+#include "util.hpp"
+
+// Days since 1970-01-01 in the proleptic Gregorian calendar, and back, after
+// Howard Hinnant's civil calendar algorithms. No time zones are involved, so
+// this doesn't go through the C library's time functions.
+static long days_from_civil(int y, int m, int d) {
+  y -= m <= 2;
+  long era = (y >= 0 ? y : y - 399) / 400;
+  long yoe = y - era * 400;
+  long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+static void civil_from_days(long z, int & y, int & m, int & d) {
+  z += 719468;
+  long era = (z >= 0 ? z : z - 146096) / 146097;
+  long doe = z - era * 146097;
+  long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  long mp = (5 * doy + 2) / 153;
+  d = doy - (153 * mp + 2) / 5 + 1;
+  m = mp < 10 ? mp + 3 : mp - 9;
+  y = yoe + era * 400 + (m <= 2);
+}
+
+std::string add_days(const std::string & date, int days) {
+  int y;
+  int m;
+  int d;
+  if (sscanf(date.c_str(), "%d-%d-%d", &y, &m, &d) != 3) {
+    error("malformed date");
+  }
+  civil_from_days(days_from_civil(y, m, d) + days, y, m, d);
+  char result[16];
+  snprintf(result, sizeof(result), "%04d-%02d-%02d", y, m, d);
+  return result;
+}
@@ -0,0 +1,11 @@
+#ifndef DATE_HPP
+#define DATE_HPP
+
+#include <string>
+
+// Calendar dates in the YYYY-MM-DD form the schedule feed uses.
+
+// The date the given number of days after (or, if negative, before) date.
+std::string add_days(const std::string & date, int days);
+
+#endif
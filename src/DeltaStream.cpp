@@ -0,0 +1,119 @@
+#include <chrono>
+#include <utility>
+#include <vector>
+
+#include "DeltaStream.hpp"
+#include "Download.hpp"
+
+// Pause before reconnecting after the stream drops
+static const int reconnect_seconds = 5;
+
+DeltaStream::DeltaStream(std::string url, std::string aspect_ratio, int minimum_width,
+                         std::function<void()> on_arrival)
+  : _url(url),
+    _aspect_ratio(aspect_ratio),
+    _minimum_width(minimum_width),
+    _on_arrival(on_arrival),
+    _stopping(false),
+    _received(0) {
+  _thread = std::thread(&DeltaStream::run, this);
+}
+
+DeltaStream::~DeltaStream() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _wake.notify_all();
+  _thread.join();
+}
+
+bool DeltaStream::take(GameDelta & delta) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_deltas.empty()) {
+    return false;
+  }
+  delta = std::move(_deltas.front());
+  _deltas.pop_front();
+  return true;
+}
+
+size_t DeltaStream::received() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _received;
+}
+
+bool DeltaStream::stopping() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _stopping;
+}
+
+void DeltaStream::run() {
+  while (!stopping()) {
+    _pending.clear();
+    _event.clear();
+    bool ended = follow_stream(_url,
+                               [this](const char * data, size_t size) { feed(data, size); },
+                               [this] { return stopping(); });
+    if (stopping()) {
+      return;
+    }
+    warning(ended ? "delta stream ended; reconnecting" : "delta stream failed; reconnecting");
+    std::unique_lock<std::mutex> lock(_mutex);
+    _wake.wait_for(lock,
+                   std::chrono::seconds(reconnect_seconds),
+                   [this] { return _stopping; });
+  }
+}
+
+// Splits the received text into lines. A "data:" line belongs to a
+// server-sent event, which is complete at the next blank line; other SSE
+// fields and comments are ignored. Any other non-blank line is a whole
+// newline-delimited message.
+void DeltaStream::feed(const char * data, size_t size) {
+  _pending.append(data, size);
+  std::string messages;
+  size_t begin = 0;
+  size_t end;
+  while ((end = _pending.find('\n', begin)) != std::string::npos) {
+    size_t length = end - begin;
+    if (length > 0 && _pending[end - 1] == '\r') {
+      length--;
+    }
+    std::string line = _pending.substr(begin, length);
+    begin = end + 1;
+
+    if (line.empty()) {
+      if (!_event.empty()) {
+        messages += _event + '\n';
+        _event.clear();
+      }
+    } else if (line.compare(0, 5, "data:") == 0) {
+      size_t payload = line.size() > 5 && line[5] == ' ' ? 6 : 5;
+      if (!_event.empty()) {
+        _event += ' ';  // lines of one event are one message
+      }
+      _event += line.substr(payload);
+    } else if (line[0] == '{' || line[0] == ' ' || line[0] == '\t') {
+      messages += line + '\n';
+    }
+  }
+  _pending.erase(0, begin);
+  if (messages.empty()) {
+    return;
+  }
+
+  std::vector<GameDelta> deltas;
+  parse_deltas(messages, _aspect_ratio, _minimum_width, deltas);
+  if (deltas.empty()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (GameDelta & delta : deltas) {
+      _deltas.push_back(std::move(delta));
+    }
+    _received += deltas.size();
+  }
+  _on_arrival();
+}
@@ -0,0 +1,58 @@
+#ifndef DELTA_STREAM_HPP
+#define DELTA_STREAM_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "JsonFilter.hpp"
+#include "util.hpp"
+
+// Long-lived connection to a push endpoint that sends a message whenever a
+// game changes, instead of the whole schedule being polled. The endpoint may
+// speak server-sent events (messages in "data:" lines, ended by a blank
+// line) or newline-delimited JSON (one message per line); see parse_deltas
+// for the message format. Messages are parsed and filtered on the stream's
+// thread and queued for the main thread, which picks them up with take. A
+// dropped connection is retried after a pause.
+class DeltaStream : Uncopyable {
+public:
+  // on_arrival is called on the stream's thread after deltas are queued.
+  DeltaStream(std::string url, std::string aspect_ratio, int minimum_width,
+              std::function<void()> on_arrival);
+  // Closes the connection.
+  ~DeltaStream();
+
+  // Takes the oldest delta, if any.
+  bool take(GameDelta & delta);
+
+  // Deltas received since the stream was opened.
+  size_t received() const;
+
+private:
+  std::string _url;
+  std::string _aspect_ratio;
+  int _minimum_width;
+  std::function<void()> _on_arrival;
+
+  // used only on the stream's thread
+  std::string _pending;  // received text not yet ending in a newline
+  std::string _event;    // data lines of the server-sent event being read
+
+  mutable std::mutex _mutex;  // guards everything below
+  std::condition_variable _wake;
+  bool _stopping;
+  std::deque<GameDelta> _deltas;
+  size_t _received;
+
+  std::thread _thread;  // started last
+
+  void run();
+  void feed(const char * data, size_t size);
+  bool stopping();
+};
+
+#endif
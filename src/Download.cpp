@@ -1,12 +1,17 @@
-#include <list>
+#include <cstring>
+#include <functional>
+#include <mutex>
 #include <string>
 
+#include <strings.h>
+
 #include "SDL.h"
 #include "SDL_image.h"
 #include "curl.h"
 
 #include "Download.hpp"
 #include "JsonFilter.hpp"
+#include "Trace.hpp"
 #include "util.hpp"
 
 struct MemoryStruct {
@@ -14,15 +19,21 @@ struct MemoryStruct {
   char * memory;
 };
 
+// Decodes the jpeg in ms, freeing its memory. Returns null, with a warning,
+// if it can't be decoded.
 static SDL_Surface * load_jpeg_from_mem(MemoryStruct ms) {
+  TRACE_SPAN("load_jpeg_from_mem");
+  SDL_Surface * jpeg = nullptr;
   SDL_RWops * source = SDL_RWFromMem(ms.memory, ms.size);
   if (source == nullptr) {
-    error("Couldn't get SDL_RWops");
-  }
-  SDL_Surface * jpeg = IMG_Load_RW(source, 1 /* free source after use */);
-  if (jpeg == nullptr) {
-    error("Couldn't load jpeg from memory");
+    warning("Couldn't get SDL_RWops");
+  } else {
+    jpeg = IMG_Load_RW(source, 1 /* free source after use */);
+    if (jpeg == nullptr) {
+      warning("Couldn't load jpeg from memory");
+    }
   }
+  free(ms.memory);
   return jpeg;
 }
 
@@ -46,38 +57,200 @@ static size_t write_memory_callback(void * contents,
   return realsize;
 }
 
-// Fetch data from the given url. Allocates memory in the memory field of the
-// MemoryStruct returned.
-static MemoryStruct fetch(std::string url) {
-  struct MemoryStruct chunk;
-  chunk.size = 0;                    /* no data yet */ 
-  chunk.memory = (char *)malloc(1);  /* will be grown as needed by the realloc above */ 
- 
-  curl_global_init(CURL_GLOBAL_ALL);
+typedef size_t (*WriteFunction)(void *, size_t, size_t, void *);
+typedef std::function<void(const char *, size_t)> ChunkHandler;
+
+static size_t write_stream_callback(void * contents,
+                                    size_t size,
+                                    size_t nmemb,
+                                    void * userp) {
+  size_t realsize = size * nmemb;
+  (*(ChunkHandler *)userp)((const char *)contents, realsize);
+  return realsize;
+}
+
+// Create a handle for a transfer of the given url that hands each chunk of
+// the body to write_function along with userp. curl_global_init is not
+// thread-safe, so it runs once no matter how many threads fetch.
+static CURL * new_curl_handle(const std::string & url,
+                              WriteFunction write_function,
+                              void * userp) {
+  static std::once_flag curl_initialized;
+  std::call_once(curl_initialized, [] { curl_global_init(CURL_GLOBAL_ALL); });
+
   CURL * curl_handle = curl_easy_init();
+  if (curl_handle == nullptr) {
+    error("curl_easy_init failed");
+  }
   curl_easy_setopt(curl_handle, CURLOPT_URL, url.c_str());
-  curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, write_memory_callback);
-  curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void *)&chunk);
+  curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, write_function);
+  curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, userp);
+  return curl_handle;
+}
+
+// Perform a transfer of the given url, handing each chunk of the body to
+// write_function along with userp. Returns false if it failed, including
+// with an HTTP error status.
+static bool perform(std::string url,
+                    WriteFunction write_function,
+                    void * userp) {
+  TRACE_SPAN("fetch");
+  CURL * curl_handle = new_curl_handle(url, write_function, userp);
+  curl_easy_setopt(curl_handle, CURLOPT_FAILONERROR, 1L);
   CURLcode result = curl_easy_perform(curl_handle);
-  if(result != CURLE_OK) {
+  curl_easy_cleanup(curl_handle);
+  return result == CURLE_OK;
+}
+
+static size_t write_string_callback(void * contents,
+                                    size_t size,
+                                    size_t nmemb,
+                                    void * userp) {
+  size_t realsize = size * nmemb;
+  ((std::string *)userp)->append((const char *)contents, realsize);
+  return realsize;
+}
+
+// If the header line is "name: value" (name matched case-insensitively),
+// stores value without its line ending.
+static void match_header(const std::string & line, const char * name, std::string & value) {
+  size_t n = strlen(name);
+  if (line.size() <= n || line[n] != ':' || strncasecmp(line.c_str(), name, n) != 0) {
+    return;
+  }
+  size_t begin = line.find_first_not_of(' ', n + 1);
+  size_t end = line.find_last_not_of("\r\n");
+  value = begin == std::string::npos || end < begin ? "" : line.substr(begin, end - begin + 1);
+}
+
+static size_t header_callback(char * buffer, size_t size, size_t nitems, void * userp) {
+  size_t realsize = size * nitems;
+  ConditionalFetch * result = (ConditionalFetch *)userp;
+  std::string line(buffer, realsize);
+  match_header(line, "ETag", result->etag);
+  match_header(line, "Last-Modified", result->last_modified);
+  return realsize;
+}
+
+ConditionalFetch fetch_if_modified(std::string url,
+                                   std::string etag,
+                                   std::string last_modified) {
+  TRACE_SPAN("fetch_if_modified");
+  ConditionalFetch result;
+  result.ok = false;
+  result.not_modified = false;
+
+  CURL * curl_handle = new_curl_handle(url, write_string_callback, (void *)&result.body);
+  curl_easy_setopt(curl_handle, CURLOPT_HEADERFUNCTION, header_callback);
+  curl_easy_setopt(curl_handle, CURLOPT_HEADERDATA, (void *)&result);
+  struct curl_slist * headers = nullptr;
+  if (!etag.empty()) {
+    headers = curl_slist_append(headers, ("If-None-Match: " + etag).c_str());
+  }
+  if (!last_modified.empty()) {
+    headers = curl_slist_append(headers, ("If-Modified-Since: " + last_modified).c_str());
+  }
+  curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, headers);
+
+  CURLcode code = curl_easy_perform(curl_handle);
+  long status = 0;
+  curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &status);
+  curl_easy_cleanup(curl_handle);
+  curl_slist_free_all(headers);
+
+  if (code == CURLE_OK && (status == 200 || status == 304)) {
+    result.ok = true;
+    result.not_modified = status == 304;
+    if (result.not_modified) {
+      // a 304 need not repeat the validators
+      if (result.etag.empty()) {
+        result.etag = etag;
+      }
+      if (result.last_modified.empty()) {
+        result.last_modified = last_modified;
+      }
+    }
+  }
+  return result;
+}
+
+// Fetch data from the given url into chunk, returning false if the transfer
+// failed. Allocates memory in the memory field of chunk either way.
+static bool fetch(std::string url, MemoryStruct & chunk) {
+  chunk.size = 0;                    /* no data yet */ 
+  chunk.memory = (char *)malloc(1);  /* will be grown as needed by the realloc above */ 
+ 
+  return perform(url, write_memory_callback, (void *)&chunk);
+}
+
+// Fetch data from the given url, handing each chunk to on_chunk as it
+// arrives rather than accumulating the whole body.
+static void fetch_streaming(std::string url, ChunkHandler on_chunk) {
+  if (!perform(url, write_stream_callback, (void *)&on_chunk)) {
     error("curl failed");
   }
+}
 
-  return chunk;
+static int progress_callback(void * clientp,
+                             curl_off_t dltotal,
+                             curl_off_t dlnow,
+                             curl_off_t ultotal,
+                             curl_off_t ulnow) {
+  (void)dltotal;
+  (void)dlnow;
+  (void)ultotal;
+  (void)ulnow;
+  return (*(std::function<bool()> *)clientp)() ? 1 : 0;
 }
 
-// Creates a list of PhotoData.
-std::list<PhotoData> get_photo_data_from_json_url(std::string url,
-                                                  std::string aspect_ratio_string,
-                                                  int minimum_width) {
-  MemoryStruct json = fetch(url);
-  std::list<PhotoData> data = parse_and_filter(json.memory,
-                                               aspect_ratio_string,
-                                               minimum_width);
-  free(json.memory);
-  return data;
+bool follow_stream(std::string url,
+                   std::function<void(const char *, size_t)> on_chunk,
+                   std::function<bool()> should_stop) {
+  ChunkHandler handler = on_chunk;
+  CURL * curl_handle = new_curl_handle(url, write_stream_callback, (void *)&handler);
+  struct curl_slist * headers = nullptr;
+  headers = curl_slist_append(headers, "Accept: text/event-stream, application/x-ndjson");
+  curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, headers);
+  // the progress callback runs about once a second even while idle, so a
+  // quiet stream can still be stopped
+  curl_easy_setopt(curl_handle, CURLOPT_NOPROGRESS, 0L);
+  curl_easy_setopt(curl_handle, CURLOPT_XFERINFOFUNCTION, progress_callback);
+  curl_easy_setopt(curl_handle, CURLOPT_XFERINFODATA, (void *)&should_stop);
+  curl_easy_setopt(curl_handle, CURLOPT_FAILONERROR, 1L);
+
+  CURLcode code = curl_easy_perform(curl_handle);
+  curl_easy_cleanup(curl_handle);
+  curl_slist_free_all(headers);
+  return code == CURLE_OK;
+}
+
+int stream_photo_data_from_json_url(std::string url,
+                                    std::string aspect_ratio_string,
+                                    int minimum_width,
+                                    Catalog & catalog,
+                                    std::function<void(size_t)> on_game) {
+  ScheduleStreamParser parser(aspect_ratio_string, minimum_width, catalog, on_game);
+  fetch_streaming(url, [&parser](const char * data, size_t size) {
+      parser.feed(data, size);
+    });
+  return parser.games_seen();
+}
+
+// Creates a catalog of PhotoData.
+Catalog get_photo_data_from_json_url(std::string url,
+                                     std::string aspect_ratio_string,
+                                     int minimum_width) {
+  Catalog catalog;
+  stream_photo_data_from_json_url(url, aspect_ratio_string, minimum_width, catalog, nullptr);
+  return catalog;
 }
 
 SDL_Surface * load_jpeg_from_url(std::string url) {
-  return load_jpeg_from_mem(fetch(url));
+  MemoryStruct chunk;
+  if (!fetch(url, chunk)) {
+    free(chunk.memory);
+    warning(("couldn't fetch " + url).c_str());
+    return nullptr;
+  }
+  return load_jpeg_from_mem(chunk);
 }
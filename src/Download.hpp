@@ -1,9 +1,42 @@
 #ifndef DOWNLOAD_HPP
 #define DOWNLOAD_HPP
 
-#include "PhotoData.hpp"
+#include <functional>
+#include <string>
 
-std::list<PhotoData> get_photo_data_from_json_url(std::string url, std::string aspect_ratio_string, int minimum_width);
+#include "SDL.h"
+
+#include "Catalog.hpp"
+
+Catalog get_photo_data_from_json_url(std::string url, std::string aspect_ratio_string, int minimum_width);
+
+// Streams the schedule at url into catalog, calling on_game with the index of
+// each game as soon as its JSON has arrived rather than after the whole body
+// has downloaded. Returns the number of games seen.
+int stream_photo_data_from_json_url(std::string url, std::string aspect_ratio_string, int minimum_width, Catalog & catalog, std::function<void(size_t)> on_game);
+// Returns null, with a warning, if the image can't be fetched or decoded.
 SDL_Surface * load_jpeg_from_url(std::string url);
 
+// Result of a conditional request.
+struct ConditionalFetch {
+  bool ok;             // the transfer completed with a 200 or 304
+  bool not_modified;   // 304: the body is unchanged and empty here
+  std::string body;
+  std::string etag;
+  std::string last_modified;
+};
+
+// Follow a long-lived response, such as an event stream, handing each chunk
+// of the body to on_chunk as it arrives, until the server ends it or
+// should_stop returns true. should_stop is polled about once a second.
+// Returns true if the server ended the response normally. Failures are
+// returned rather than fatal.
+bool follow_stream(std::string url,
+                   std::function<void(const char *, size_t)> on_chunk,
+                   std::function<bool()> should_stop);
+
+// Fetch url unless it still matches the given validators, either of which
+// may be empty. Failures are returned rather than fatal.
+ConditionalFetch fetch_if_modified(std::string url, std::string etag, std::string last_modified);
+
 #endif
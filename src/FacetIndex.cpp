@@ -0,0 +1,135 @@
+#include <utility>
+
+#include "FacetIndex.hpp"
+
+void FacetIndex::clear() {
+  for (int f = 0; f < n_facets; f++) {
+    _names[f].clear();
+    _ids[f].clear();
+    _bitmaps[f].clear();
+  }
+  _away.clear();
+  _home.clear();
+  _venue.clear();
+  _date.clear();
+  _indexed = 0;
+}
+
+// Sets photo i's bit in the bitmap for name, adding the value if it's new.
+// Photos without the field get no value.
+uint32_t FacetIndex::add(Facet facet, const Catalog & catalog, TextRef name, size_t i) {
+  if (name.length == 0) {
+    return no_value;
+  }
+  auto inserted = _ids[facet].insert(std::make_pair(catalog.str(name), (uint32_t)_names[facet].size()));
+  uint32_t id = inserted.first->second;
+  if (inserted.second) {
+    _names[facet].push_back(inserted.first->first);
+    _bitmaps[facet].push_back(std::vector<uint64_t>());
+  }
+  std::vector<uint64_t> & bits = _bitmaps[facet][id];
+  if (bits.size() <= i / 64) {
+    bits.resize(i / 64 + 1, 0);
+  }
+  bits[i / 64] |= (uint64_t)1 << (i % 64);
+  return id;
+}
+
+void FacetIndex::sync(const Catalog & catalog) {
+  for (size_t i = _indexed; i < catalog.size(); i++) {
+    _away.push_back(add(facet_team, catalog, catalog.away_team_ref(i), i));
+    _home.push_back(add(facet_team, catalog, catalog.home_team_ref(i), i));
+    _venue.push_back(add(facet_venue, catalog, catalog.venue_ref(i), i));
+    _date.push_back(add(facet_date, catalog, catalog.game_date_ref(i), i));
+  }
+  _indexed = catalog.size();
+}
+
+// ORs the bitmaps of the given values into bits. Bitmaps stop at the last
+// photo with their value, so the rest of bits stays clear.
+void FacetIndex::select_values(Facet facet,
+                               const std::vector<uint32_t> & ids,
+                               std::vector<uint64_t> & bits) const {
+  for (uint32_t id : ids) {
+    const std::vector<uint64_t> & value_bits = _bitmaps[facet][id];
+    for (size_t w = 0; w < value_bits.size(); w++) {
+      bits[w] |= value_bits[w];
+    }
+  }
+}
+
+void FacetIndex::select(const Selection & selection,
+                        std::vector<uint32_t> & matches,
+                        Counts & counts) const {
+  matches.clear();
+  for (int f = 0; f < n_facets; f++) {
+    counts.values[f].assign(_names[f].size(), 0);
+  }
+  size_t n_words = (_indexed + 63) / 64;
+
+  // one bitmap per restricted facet
+  std::vector<std::vector<uint64_t>> restrictions;
+  std::vector<uint32_t> ids;
+  if (!selection.teams.empty()) {
+    ids.clear();
+    for (const std::string & team : selection.teams) {
+      auto found = _ids[facet_team].find(team);
+      if (found != _ids[facet_team].end()) {
+        ids.push_back(found->second);
+      }
+    }
+    restrictions.push_back(std::vector<uint64_t>(n_words, 0));
+    select_values(facet_team, ids, restrictions.back());
+  }
+  if (!selection.venues.empty()) {
+    ids.clear();
+    for (const std::string & venue : selection.venues) {
+      auto found = _ids[facet_venue].find(venue);
+      if (found != _ids[facet_venue].end()) {
+        ids.push_back(found->second);
+      }
+    }
+    restrictions.push_back(std::vector<uint64_t>(n_words, 0));
+    select_values(facet_venue, ids, restrictions.back());
+  }
+  if (!selection.first_date.empty() || !selection.last_date.empty()) {
+    // dates are ISO strings, so they compare in date order
+    ids.clear();
+    for (size_t v = 0; v < _names[facet_date].size(); v++) {
+      const std::string & date = _names[facet_date][v];
+      if ((selection.first_date.empty() || date >= selection.first_date)
+          && (selection.last_date.empty() || date <= selection.last_date)) {
+        ids.push_back(v);
+      }
+    }
+    restrictions.push_back(std::vector<uint64_t>(n_words, 0));
+    select_values(facet_date, ids, restrictions.back());
+  }
+
+  for (size_t w = 0; w < n_words; w++) {
+    uint64_t word = ~(uint64_t)0;
+    if (w == n_words - 1 && _indexed % 64 != 0) {
+      word = ((uint64_t)1 << (_indexed % 64)) - 1;
+    }
+    for (const std::vector<uint64_t> & bits : restrictions) {
+      word &= bits[w];
+    }
+    while (word != 0) {
+      uint32_t i = w * 64 + __builtin_ctzll(word);
+      word &= word - 1;
+      matches.push_back(i);
+      if (_away[i] != no_value) {
+        counts.values[facet_team][_away[i]]++;
+      }
+      if (_home[i] != no_value && _home[i] != _away[i]) {
+        counts.values[facet_team][_home[i]]++;
+      }
+      if (_venue[i] != no_value) {
+        counts.values[facet_venue][_venue[i]]++;
+      }
+      if (_date[i] != no_value) {
+        counts.values[facet_date][_date[i]]++;
+      }
+    }
+  }
+}
@@ -0,0 +1,83 @@
+#ifndef FACET_INDEX_HPP
+#define FACET_INDEX_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Catalog.hpp"
+
+// Bitmap indexes over the teams, venue and date of each game in a catalog.
+// Each distinct value of a facet has a bitmap with a bit per photo, so a
+// selection like "Yankees games in June" is the OR of the selected values'
+// bitmaps within each facet, ANDed across facets, word by word. A game is
+// under both of its teams.
+class FacetIndex {
+public:
+  enum Facet {
+    facet_team,
+    facet_venue,
+    facet_date,
+    n_facets
+  };
+
+  // Values to keep. An empty list leaves that facet unrestricted. Dates are
+  // an inclusive range of YYYY-MM-DD strings; either end may be empty.
+  struct Selection {
+    std::vector<std::string> teams;
+    std::vector<std::string> venues;
+    std::string first_date;
+    std::string last_date;
+
+    bool empty() const {
+      return teams.empty() && venues.empty() && first_date.empty() && last_date.empty();
+    }
+  };
+
+  // Per facet, the number of selected photos with each value, indexed like
+  // value().
+  struct Counts {
+    std::vector<uint32_t> values[n_facets];
+  };
+
+  FacetIndex() : _indexed(0) {}
+
+  // Forget everything. Needed whenever photos are changed, removed or
+  // inserted anywhere but the end of the catalog.
+  void clear();
+
+  // Index photos appended to the catalog since the last sync.
+  void sync(const Catalog & catalog);
+
+  size_t value_count(Facet facet) const { return _names[facet].size(); }
+  const std::string & value(Facet facet, size_t v) const { return _names[facet][v]; }
+
+  // Indices of the selected photos, in catalog order, with the facet counts
+  // over them gathered in the same pass.
+  void select(const Selection & selection,
+              std::vector<uint32_t> & matches,
+              Counts & counts) const;
+
+private:
+  static const uint32_t no_value = UINT32_MAX;
+
+  std::vector<std::string> _names[n_facets];
+  std::unordered_map<std::string, uint32_t> _ids[n_facets];
+  std::vector<std::vector<uint64_t>> _bitmaps[n_facets];  // per value
+
+  // per photo value ids, for counting
+  std::vector<uint32_t> _away;
+  std::vector<uint32_t> _home;
+  std::vector<uint32_t> _venue;
+  std::vector<uint32_t> _date;
+
+  size_t _indexed;  // photos [0, _indexed) are indexed
+
+  uint32_t add(Facet facet, const Catalog & catalog, TextRef name, size_t i);
+  void select_values(Facet facet,
+                     const std::vector<uint32_t> & ids,
+                     std::vector<uint64_t> & bits) const;
+};
+
+#endif
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <queue>
+#include <utility>
+
+#include "CatalogCache.hpp"
+#include "Download.hpp"
+#include "FeedSet.hpp"
+#include "JsonFilter.hpp"
+
+// Each catalog contributes its next game to a heap ordered by game time.
+// Times are ISO 8601 UTC strings, so they compare in time order.
+Catalog merge_by_game_time(const std::vector<const Catalog *> & catalogs) {
+  struct Head {
+    std::string time;
+    size_t catalog;
+    size_t index;
+    bool operator>(const Head & other) const {
+      return time != other.time ? time > other.time : catalog > other.catalog;
+    }
+  };
+  std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+  size_t total = 0;
+  for (size_t c = 0; c < catalogs.size(); c++) {
+    total += catalogs[c]->size();
+    if (!catalogs[c]->empty()) {
+      heads.push(Head{catalogs[c]->str(catalogs[c]->game_time_ref(0)), c, 0});
+    }
+  }
+  Catalog merged;
+  if (catalogs.size() == 1) {
+    merged.append(*catalogs[0]);
+    return merged;
+  }
+  merged.reserve(total, 0, 0);
+  while (!heads.empty()) {
+    Head head = heads.top();
+    heads.pop();
+    const Catalog & from = *catalogs[head.catalog];
+    merged.append(from, head.index, head.index + 1);
+    if (head.index + 1 < from.size()) {
+      heads.push(Head{from.str(from.game_time_ref(head.index + 1)), head.catalog, head.index + 1});
+    }
+  }
+  return merged;
+}
+
+FeedSet::FeedSet(std::vector<UrlForDate> feeds, std::string aspect_ratio, int minimum_width)
+  : _feeds(feeds),
+    _aspect_ratio(aspect_ratio),
+    _minimum_width(minimum_width),
+    _on_update([] {}) {
+}
+
+// Loads still running refer to their date's entry, so the entries must
+// outlive them.
+FeedSet::~FeedSet() {
+  std::vector<std::future<void>> loads;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto & date : _dates) {
+      for (std::future<void> & load : date.second.loads) {
+        loads.push_back(std::move(load));
+      }
+    }
+  }
+  for (std::future<void> & load : loads) {
+    if (load.valid()) {
+      load.wait();
+    }
+  }
+}
+
+Catalog FeedSet::merged(const DateFeeds & feeds) const {
+  std::vector<const Catalog *> loaded;
+  for (size_t f = 0; f < feeds.games.size(); f++) {
+    if (feeds.states[f] == feed_loaded) {
+      loaded.push_back(&feeds.games[f]);
+    }
+  }
+  return merge_by_game_time(loaded);
+}
+
+// Runs on its own thread. A failed fetch or unparseable schedule is
+// reported, not fatal, so the other feeds carry on.
+void FeedSet::load_feed(std::string date, size_t feed) {
+  std::string url = _feeds[feed](date);
+  CatalogCache cache(url, _aspect_ratio, _minimum_width);
+  Catalog games;
+  bool ok = cache.load(games);
+  if (!ok) {
+    ConditionalFetch response = fetch_if_modified(url, "", "");
+    ok = response.ok && parse_and_filter(response.body.c_str(), _aspect_ratio, _minimum_width, games);
+    if (ok) {
+      cache.save(games);
+    } else {
+      warning(("couldn't load feed " + url).c_str());
+    }
+  }
+
+  bool queued = false;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    DateFeeds & feeds = _dates[date];
+    feeds.states[feed] = ok ? feed_loaded : feed_failed;
+    feeds.games[feed] = std::move(games);
+    if (ok && feeds.returned) {
+      _updates.push_back(std::make_pair(date, merged(feeds)));
+      queued = true;
+    }
+    _arrived.notify_all();
+  }
+  if (queued) {
+    _on_update();
+  }
+}
+
+Catalog FeedSet::load(const std::string & date, bool * failed) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  DateFeeds & feeds = _dates[date];
+  if (feeds.states.empty()) {
+    feeds.states.assign(_feeds.size(), feed_failed);
+    feeds.games.resize(_feeds.size());
+    feeds.loads.resize(_feeds.size());
+  }
+  feeds.returned = false;
+  for (size_t f = 0; f < _feeds.size(); f++) {
+    if (feeds.states[f] == feed_failed) {
+      feeds.states[f] = feed_loading;
+      feeds.loads[f] = std::async(std::launch::async, &FeedSet::load_feed, this, date, f);
+    }
+  }
+  _arrived.wait(lock, [&feeds] {
+      return std::count(feeds.states.begin(), feeds.states.end(), feed_loaded) > 0
+        || std::count(feeds.states.begin(), feeds.states.end(), feed_loading) == 0;
+    });
+  feeds.returned = true;
+  if (failed != nullptr) {
+    *failed = std::count(feeds.states.begin(), feeds.states.end(), feed_loaded) == 0;
+  }
+  return merged(feeds);
+}
+
+void FeedSet::update(const std::string & date, size_t feed, Catalog games) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    DateFeeds & feeds = _dates[date];
+    if (feeds.states.empty()) {
+      feeds.states.assign(_feeds.size(), feed_failed);
+      feeds.games.resize(_feeds.size());
+      feeds.loads.resize(_feeds.size());
+      feeds.returned = true;
+    }
+    feeds.states[feed] = feed_loaded;
+    feeds.games[feed] = std::move(games);
+    _updates.push_back(std::make_pair(date, merged(feeds)));
+  }
+  _on_update();
+}
+
+bool FeedSet::take_update(std::string & date, Catalog & games) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_updates.empty()) {
+    return false;
+  }
+  date = _updates.front().first;
+  games = std::move(_updates.front().second);
+  _updates.pop_front();
+  return true;
+}
+
+void FeedSet::retain(const std::vector<std::string> & dates) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (auto it = _dates.begin(); it != _dates.end(); ) {
+    bool loading = std::count(it->second.states.begin(), it->second.states.end(), feed_loading) > 0;
+    if (!loading && std::find(dates.begin(), dates.end(), it->first) == dates.end()) {
+      it = _dates.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
@@ -0,0 +1,85 @@
+#ifndef FEED_SET_HPP
+#define FEED_SET_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Catalog.hpp"
+#include "util.hpp"
+
+// Merges catalogs whose games are each in game time order into one catalog
+// in game time order. Games at the same time keep the order of catalogs.
+Catalog merge_by_game_time(const std::vector<const Catalog *> & catalogs);
+
+// The schedule feeds shown together, such as one per league. A date's
+// catalog is the games of every feed on that date, merged by game time.
+// Feeds are loaded concurrently, and a feed that is slow or fails doesn't
+// keep the others from being shown: load returns as soon as one feed has
+// games, and the merged catalog is queued again each time another feed
+// arrives or changes.
+class FeedSet : Uncopyable {
+public:
+  typedef std::function<std::string(const std::string &)> UrlForDate;
+
+  FeedSet(std::vector<UrlForDate> feeds, std::string aspect_ratio, int minimum_width);
+  // Waits for loads in flight.
+  ~FeedSet();
+
+  // Called, on whichever thread queued it, after a merged catalog is
+  // queued. Set before the first load.
+  void set_on_update(std::function<void()> on_update) { _on_update = on_update; }
+
+  size_t size() const { return _feeds.size(); }
+  std::string url(size_t feed, const std::string & date) const { return _feeds[feed](date); }
+
+  // Starts every feed's load for date, from its cache or the network, and
+  // blocks until one has games or all have failed. Returns the merge of the
+  // feeds finished so far. failed, if given, tells a date whose every feed
+  // failed from one with no games.
+  Catalog load(const std::string & date, bool * failed = nullptr);
+
+  // Replace one feed's games for date, as when a refresh finds it changed,
+  // and queue the new merged catalog.
+  void update(const std::string & date, size_t feed, Catalog games);
+
+  // Takes the oldest queued merged catalog, if any.
+  bool take_update(std::string & date, Catalog & games);
+
+  // Drop the games kept for dates not listed, unless still loading.
+  void retain(const std::vector<std::string> & dates);
+
+private:
+  enum FeedState {
+    feed_loading,
+    feed_loaded,
+    feed_failed
+  };
+
+  struct DateFeeds {
+    std::vector<FeedState> states;
+    std::vector<Catalog> games;
+    std::vector<std::future<void>> loads;
+    bool returned;  // load has returned, so later arrivals are queued
+  };
+
+  std::vector<UrlForDate> _feeds;
+  std::string _aspect_ratio;
+  int _minimum_width;
+  std::function<void()> _on_update;
+
+  std::mutex _mutex;  // guards everything below
+  std::condition_variable _arrived;
+  std::map<std::string, DateFeeds> _dates;
+  std::deque<std::pair<std::string, Catalog>> _updates;
+
+  void load_feed(std::string date, size_t feed);
+  Catalog merged(const DateFeeds & feeds) const;
+};
+
+#endif
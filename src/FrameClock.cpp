@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "FrameClock.hpp"
+
+FrameClock::FrameClock(double frame_ms)
+  : _frame_ms(frame_ms), _report(false), _running(false), _start(0), _next(0),
+    _frames(0), _dropped(0), _work_begin(0), _total_ms(0), _worst_ms(0) {
+}
+
+void FrameClock::start() {
+  _running = true;
+  _start = SDL_GetPerformanceCounter();
+  _next = 0;
+  _frames = 0;
+  _dropped = 0;
+  _total_ms = 0;
+  _worst_ms = 0;
+}
+
+int FrameClock::ms_until_frame() const {
+  if (!_running) {
+    return -1;
+  }
+  double ms = _frame_ms * _next - elapsed_ms(_start);
+  return ms <= 0 ? 0 : (int)std::ceil(ms);
+}
+
+double FrameClock::ms_left() const {
+  return _running ? std::max(0.0, _frame_ms * _next - elapsed_ms(_start)) : _frame_ms;
+}
+
+bool FrameClock::is_frame_due() const {
+  return _running && elapsed_ms(_start) >= _frame_ms * _next;
+}
+
+void FrameClock::begin_frame() {
+  uint64_t due = (uint64_t)(elapsed_ms(_start) / _frame_ms);
+  if (due > _next) {
+    _dropped += due - _next;
+  }
+  _next = due + 1;
+  _frames++;
+  _work_begin = SDL_GetPerformanceCounter();
+}
+
+void FrameClock::end_frame() {
+  double ms = elapsed_ms(_work_begin);
+  _total_ms += ms;
+  _worst_ms = std::max(_worst_ms, ms);
+}
+
+void FrameClock::stop() {
+  if (_report) {
+    fprintf(stderr, "transition: %llu frames in %.1f ms, %llu dropped;"
+            " main thread %.2f ms a frame average, %.2f slowest\n",
+            (unsigned long long)_frames, elapsed_ms(_start), (unsigned long long)_dropped,
+            _frames > 0 ? _total_ms / _frames : 0, _worst_ms);
+  }
+  _running = false;
+}
+
+double FrameClock::elapsed_ms(Uint64 since) {
+  return (SDL_GetPerformanceCounter() - since) * 1000.0 / SDL_GetPerformanceFrequency();
+}
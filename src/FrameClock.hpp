@@ -0,0 +1,49 @@
+#ifndef FRAME_CLOCK_HPP
+#define FRAME_CLOCK_HPP
+
+#include <cstdint>
+
+#include "SDL.h"
+
+// Paces the frames of a transition: frame k is due frame_ms * k after the
+// transition started, so a late frame doesn't push back the ones after it.
+// Frames whose time passed before one could be drawn are dropped. With
+// reporting on, each transition's count of frames and drops is printed.
+class FrameClock {
+public:
+  explicit FrameClock(double frame_ms);
+
+  void enable_report() { _report = true; }
+  bool is_reporting() const { return _report; }
+  bool is_running() const { return _running; }
+
+  void start();
+
+  // Milliseconds until the next frame is due, or -1 if none is.
+  int ms_until_frame() const;
+
+  // Time left before the next frame is due, for work between frames; a
+  // whole frame's when no transition is running.
+  double ms_left() const;
+
+  bool is_frame_due() const;
+  void begin_frame();
+  void end_frame();
+  void stop();
+
+private:
+  double _frame_ms;
+  bool _report;
+  bool _running;
+  Uint64 _start;
+  uint64_t _next;  // index of the next frame due
+  uint64_t _frames;
+  uint64_t _dropped;
+  Uint64 _work_begin;
+  double _total_ms;
+  double _worst_ms;
+
+  static double elapsed_ms(Uint64 since);
+};
+
+#endif
@@ -0,0 +1,34 @@
+#include <chrono>
+
+#include "FrameScheduler.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+void FrameScheduler::post(Priority priority, std::function<void()> task) {
+  _tasks[priority].push_back(task);
+}
+
+size_t FrameScheduler::backlog() const {
+  size_t n = 0;
+  for (auto & tasks : _tasks) {
+    n += tasks.size();
+  }
+  return n;
+}
+
+FrameScheduler::Stats FrameScheduler::run(double budget_ms) {
+  Clock::time_point begin = Clock::now();
+  Stats stats = {0, 0, 0};
+  for (auto & tasks : _tasks) {
+    while (!tasks.empty() && (stats.ran == 0 || stats.ms < budget_ms)) {
+      // a task may post more, so take it off the queue first
+      std::function<void()> task = std::move(tasks.front());
+      tasks.pop_front();
+      task();
+      stats.ran++;
+      stats.ms = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+    }
+  }
+  stats.backlog = backlog();
+  return stats;
+}
@@ -0,0 +1,41 @@
+#ifndef FRAME_SCHEDULER_HPP
+#define FRAME_SCHEDULER_HPP
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+
+#include "util.hpp"
+
+// Main-thread work that needn't happen the moment it's asked for, run
+// between frames so it doesn't make one late. Each call to run takes tasks
+// in priority order, FIFO within a priority, until its budget is spent,
+// leaving the rest for the next frame. At least one task runs per call, so
+// a task longer than any budget still gets its turn. Not thread-safe.
+class FrameScheduler : Uncopyable {
+public:
+  enum Priority {
+    urgent,  // visible in the next frame or two
+    soon,
+    idle,    // housekeeping
+    n_priorities
+  };
+
+  // What one call to run did.
+  struct Stats {
+    unsigned ran;
+    size_t backlog;  // tasks left for later frames
+    double ms;
+  };
+
+  void post(Priority priority, std::function<void()> task);
+
+  size_t backlog() const;
+
+  Stats run(double budget_ms);
+
+private:
+  std::deque<std::function<void()>> _tasks[n_priorities];
+};
+
+#endif
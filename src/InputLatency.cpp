@@ -0,0 +1,39 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "InputLatency.hpp"
+
+void InputLatency::handled(Uint64 dequeued) {
+  _pending.push_back(Pending{dequeued, SDL_GetPerformanceCounter()});
+}
+
+void InputLatency::presented(Uint64 requested, Uint64 presented, double present_ms) {
+  while (!_pending.empty() && _pending.front().dequeued <= requested) {
+    const Pending & key = _pending.front();
+    double handle_ms = ms_between(key.dequeued, key.handled);
+    double wait_ms = requested > key.handled ? ms_between(key.handled, requested) : 0;
+    double total_ms = ms_between(key.dequeued, presented);
+    _stages[handle].record(handle_ms);
+    _stages[wait].record(wait_ms);
+    _stages[compose].record(std::max(0.0, total_ms - handle_ms - wait_ms - present_ms));
+    _stages[present].record(present_ms);
+    _stages[total].record(total_ms);
+    _pending.pop_front();
+  }
+}
+
+void InputLatency::report() const {
+  static const char * names[n_stages] = {"handle", "wait", "compose", "present", "total"};
+  fprintf(stderr, "input to photon: %llu key presses, ms\n",
+          (unsigned long long)_stages[total].count());
+  fprintf(stderr, "  %-8s %8s %8s %8s %8s\n", "", "p50", "p95", "p99", "max");
+  for (int stage = 0; stage < n_stages; stage++) {
+    const LatencyHistogram & h = _stages[stage];
+    fprintf(stderr, "  %-8s %8.2f %8.2f %8.2f %8.2f\n", names[stage],
+            h.percentile_ms(0.50), h.percentile_ms(0.95), h.percentile_ms(0.99), h.max_ms());
+  }
+}
+
+double InputLatency::ms_between(Uint64 from, Uint64 to) {
+  return (to - from) * 1000.0 / SDL_GetPerformanceFrequency();
+}
@@ -0,0 +1,60 @@
+#ifndef INPUT_LATENCY_HPP
+#define INPUT_LATENCY_HPP
+
+#include <deque>
+
+#include "SDL.h"
+
+#include "LatencyHistogram.hpp"
+
+// Input-to-photon latency: from a key press being taken off the queue to
+// the first frame showing its effect coming back from
+// SDL_UpdateWindowSurface. That's split into handling the key, waiting
+// for the frame showing it to be rendered, composing it (with any wait
+// for the composer) and presenting it. Key presses that change nothing on
+// screen aren't counted.
+class InputLatency {
+public:
+  enum Stage {
+    handle,
+    wait,
+    compose,
+    present,
+    total,
+    n_stages
+  };
+
+  InputLatency() : _enabled(false) {
+  }
+
+  void enable() {
+    _enabled = true;
+  }
+
+  bool is_enabled() const { return _enabled; }
+
+  // A key press taken off the queue at dequeued was just handled.
+  void handled(Uint64 dequeued);
+
+  // A frame rendered at requested came back from being presented at
+  // presented, after present_ms in SDL_UpdateWindowSurface. It shows key
+  // presses taken off the queue before it was rendered. Times are
+  // performance counters.
+  void presented(Uint64 requested, Uint64 presented, double present_ms);
+
+  void report() const;
+
+private:
+  struct Pending {
+    Uint64 dequeued;
+    Uint64 handled;
+  };
+
+  bool _enabled;
+  std::deque<Pending> _pending;  // awaiting a frame, in order taken
+  LatencyHistogram _stages[n_stages];
+
+  static double ms_between(Uint64 from, Uint64 to);
+};
+
+#endif
@@ -1,65 +1,320 @@
-#include <iostream>
+#include <climits>
+#include <utility>
 
 #include "json11.hpp"
 
 #include "JsonFilter.hpp"
-#include "PhotoData.hpp"
+#include "Trace.hpp"
 #include "util.hpp"
 
-static json11::Json parse_json(const char * json_string) {
+// Warns and returns false if json_string isn't valid JSON.
+static bool parse_json(const char * json_string, json11::Json & json) {
   std::string err;
-  json11::Json json = json11::Json::parse(json_string, err);
+  json = json11::Json::parse(json_string, err);
   if (!err.empty()) {
-    std::cerr << err;
-    error("could not parse json");
+    warning(("could not parse json: " + err).c_str());
+    return false;
   }
-  return json;
+  return true;
 }
 
-// From the given JSON, select a sequence of photos. Each photo generally comes
-// in multiple aspect ratios and sizes. Of the photos with the given aspect
-// ratio, grab the photo with the smallest width that is at least minimum_width.
-static std::list<PhotoData> filter(json11::Json & json,
-                                   std::string aspect_ratio_string,
-                                   int minimum_width) {
-  std::list<PhotoData> data;
-
-  json = json["dates"][0]["games"];
-  for (json11::Json i : json.array_items()) {
-    PhotoData pd;
-    json11::Json mlb = i["content"]["editorial"]["recap"]["mlb"];
-    pd.headline = mlb["headline"].string_value();
-    pd.subhead = mlb["subhead"].string_value();
-    int best_width = INT_MAX;
-    int best_height = INT_MAX;
-    std::string best_url;
-    for (json11::Json j : mlb["image"]["cuts"].array_items()) {
-      std::string url;
-      if (j["aspectRatio"].string_value() != aspect_ratio_string) {
-        continue;
+// Teams, venue and date of the game. The official date is the schedule
+// date the game is listed under, which for night games differs from the UTC
+// date in gameDate.
+static GameInfo game_info(const json11::Json & game, const std::string & schedule_date) {
+  GameInfo info;
+  info.game_pk = (long long)game["gamePk"].number_value();
+  info.date = game["officialDate"].string_value();
+  if (info.date.empty()) {
+    info.date = schedule_date;
+  }
+  if (info.date.empty()) {
+    info.date = game["gameDate"].string_value().substr(0, 10);
+  }
+  info.time = game["gameDate"].string_value();
+  info.away_team = game["teams"]["away"]["team"]["name"].string_value();
+  info.home_team = game["teams"]["home"]["team"]["name"].string_value();
+  info.venue = game["venue"]["name"].string_value();
+  return info;
+}
+
+// Each photo generally comes in multiple aspect ratios and sizes. Every cut
+// of the game's photo is added to the catalog. Of the cuts with the given
+// aspect ratio, the one with the smallest width that is at least
+// minimum_width is selected. Text is copied straight from the parsed JSON
+// into the catalog's arena. Returns false, adding nothing, if no cut
+// qualifies, as for a game without a recap yet; otherwise stores the
+// photo's index in added.
+static bool filter_game(const json11::Json & game,
+                        const std::string & schedule_date,
+                        const std::string & aspect_ratio_string,
+                        int minimum_width,
+                        Catalog & catalog,
+                        size_t & added) {
+  const json11::Json & mlb = game["content"]["editorial"]["recap"]["mlb"];
+  const json11::Json::array & cuts = mlb["image"]["cuts"].array_items();
+  int best_width = INT_MAX;
+  size_t best_cut = 0;
+  for (size_t j = 0; j < cuts.size(); j++) {
+    int width = cuts[j]["width"].int_value();
+    if (cuts[j]["aspectRatio"].string_value() != aspect_ratio_string) {
+      continue;
+    }
+    if (width < minimum_width) {
+      continue;
+    }
+    if (width < best_width) {
+      best_width = width;
+      best_cut = j;
+    }
+  }
+  if (best_width == INT_MAX) {
+    return false;
+  }
+
+  size_t i = catalog.add_photo(mlb["headline"].string_value(),
+                               mlb["subhead"].string_value());
+  catalog.set_game(i, game_info(game, schedule_date));
+  for (const json11::Json & j : cuts) {
+    catalog.add_cut(j["aspectRatio"].string_value(), j["src"].string_value(),
+                    j["width"].int_value(), j["height"].int_value());
+  }
+  catalog.set_selected_cut(i, best_cut);
+  added = i;
+  return true;
+}
+
+// From the given JSON, select a sequence of photos, one per game that has
+// a usable one.
+static void filter(const json11::Json & json,
+                   std::string aspect_ratio_string,
+                   int minimum_width,
+                   Catalog & catalog) {
+  const json11::Json & date = json["dates"][0];
+  for (const json11::Json & i : date["games"].array_items()) {
+    size_t added;
+    filter_game(i, date["date"].string_value(), aspect_ratio_string, minimum_width, catalog, added);
+  }
+}
+
+bool parse_and_filter(const char * json_string, std::string aspect_ratio, int minimum_width, Catalog & catalog) {
+  TRACE_SPAN("parse_and_filter");
+  json11::Json json;
+  if (!parse_json(json_string, json)) {
+    return false;
+  }
+  filter(json, aspect_ratio, minimum_width, catalog);
+  return true;
+}
+
+static bool delta_from_json(const json11::Json & message,
+                            const std::string & aspect_ratio,
+                            int minimum_width,
+                            GameDelta & delta) {
+  delta.date = message["date"].string_value();
+  if (delta.date.empty()) {
+    return false;
+  }
+  if (message["removed"].is_number()) {
+    delta.removed = true;
+    delta.game_pk = (long long)message["removed"].number_value();
+    return true;
+  }
+  const json11::Json & game = message["game"];
+  if (!game.is_object() || !game["gamePk"].is_number()) {
+    return false;
+  }
+  delta.removed = false;
+  delta.game_pk = (long long)game["gamePk"].number_value();
+  size_t added;
+  return filter_game(game, delta.date, aspect_ratio, minimum_width, delta.game, added);
+}
+
+// parse_multi stops at the first malformed value; parsing resumes on the
+// line after it.
+void parse_deltas(const std::string & text,
+                  std::string aspect_ratio,
+                  int minimum_width,
+                  std::vector<GameDelta> & deltas) {
+  size_t begin = 0;
+  while (begin < text.size()) {
+    std::string rest = text.substr(begin);
+    std::string::size_type stop = 0;
+    std::string err;
+    std::vector<json11::Json> messages = json11::Json::parse_multi(rest, stop, err);
+    // a malformed value still leaves a (null) entry at the end
+    size_t n_parsed = err.empty() ? messages.size() : messages.size() - 1;
+    for (size_t i = 0; i < n_parsed; i++) {
+      GameDelta delta;
+      if (delta_from_json(messages[i], aspect_ratio, minimum_width, delta)) {
+        deltas.push_back(std::move(delta));
+      } else {
+        warning("skipping delta message without a date and a game with a usable photo");
       }
-      int width = j["width"].int_value();
-      if (width < minimum_width) {
+    }
+    if (err.empty()) {
+      return;
+    }
+    warning(("skipping malformed delta message: " + err).c_str());
+    size_t newline = text.find('\n', begin + stop);
+    if (newline == std::string::npos) {
+      return;
+    }
+    begin = newline + 1;
+  }
+}
+
+PhotoCut select_cut(const Catalog & catalog, size_t i, const std::string & aspect_ratio, int pixel_width) {
+  const CatalogCut * best = nullptr;
+  const CatalogCut * widest = nullptr;
+  for (size_t j = 0; j < catalog.cut_count(i); j++) {
+    const CatalogCut & cut = catalog.cut(i, j);
+    if (!catalog.text_equals(cut.aspect_ratio, aspect_ratio)) {
+      continue;
+    }
+    if (widest == nullptr || cut.width > widest->width) {
+      widest = &cut;
+    }
+    if (cut.width >= pixel_width && (best == nullptr || cut.width < best->width)) {
+      best = &cut;
+    }
+  }
+  PhotoCut selected;
+  selected.aspect_ratio = aspect_ratio;
+  if (best == nullptr) {
+    best = widest;
+  }
+  if (best != nullptr) {
+    selected.url = catalog.str(best->url);
+    selected.width = best->width;
+    selected.height = best->height;
+  } else {
+    selected.url = catalog.url(i);
+    selected.width = catalog.width(i);
+    selected.height = catalog.height(i);
+  }
+  return selected;
+}
+
+ScheduleStreamParser::ScheduleStreamParser(std::string aspect_ratio,
+                                           int minimum_width,
+                                           Catalog & catalog,
+                                           std::function<void(size_t)> on_game)
+  : _aspect_ratio(aspect_ratio),
+    _minimum_width(minimum_width),
+    _catalog(catalog),
+    _on_game(on_game),
+    _in_string(false),
+    _escaped(false),
+    _capturing(false),
+    _capture_depth(0),
+    _games_seen(0) {
+}
+
+// True if the string being read is the value of dates[0].date.
+bool ScheduleStreamParser::at_schedule_date() const {
+  return _stack.size() == 3
+    && _stack[0].is_object && _stack[0].key == "dates"
+    && !_stack[1].is_object && _stack[1].index == 0
+    && _stack[2].is_object && !_stack[2].expect_key && _stack[2].key == "date";
+}
+
+// True if the next value opened is an element of dates[0].games.
+bool ScheduleStreamParser::at_games_array() const {
+  return _stack.size() == 4
+    && _stack[0].is_object && _stack[0].key == "dates"
+    && !_stack[1].is_object && _stack[1].index == 0
+    && _stack[2].is_object && _stack[2].key == "games"
+    && !_stack[3].is_object;
+}
+
+void ScheduleStreamParser::finish_game() {
+  json11::Json game;
+  size_t i;
+  if (parse_json(_game.c_str(), game)
+      && filter_game(game, _date, _aspect_ratio, _minimum_width, _catalog, i) && _on_game) {
+    _on_game(i);
+  }
+  _games_seen++;
+  _capturing = false;
+  _game.clear();
+}
+
+// Only the structure is tracked here: brace and bracket nesting, the key of
+// each enclosing object member and the index of each enclosing array element.
+// Game objects are copied out verbatim and handed to json11 once complete.
+void ScheduleStreamParser::feed(const char * data, size_t size) {
+  TRACE_SPAN("ScheduleStreamParser::feed");
+  for (size_t i = 0; i < size; i++) {
+    char c = data[i];
+    if (_capturing) {
+      _game += c;
+    }
+    // only keys of the outer levels are needed to locate the games array
+    bool record_key = !_capturing && _stack.size() <= 3
+      && !_stack.empty() && _stack.back().is_object && _stack.back().expect_key;
+    bool record_date = !_capturing && at_schedule_date();
+
+    if (_in_string) {
+      if (_escaped) {
+        _escaped = false;
+      } else if (c == '\\') {
+        _escaped = true;
+      } else if (c == '"') {
+        _in_string = false;
+        if (record_key) {
+          _stack.back().key = _string;
+        } else if (record_date) {
+          _date = _string;
+        }
         continue;
       }
-      if (width < best_width) {
-        best_width = width;
-        best_height = j["height"].int_value();
-        best_url = j["src"].string_value();
+      if (record_key || record_date) {
+        _string += c;
       }
+      continue;
     }
-    if (best_width == INT_MAX) {
-      error("couldn't find photo with width at least minimum_width");
+
+    switch (c) {
+    case '"':
+      _in_string = true;
+      _string.clear();
+      break;
+    case '{':
+      if (!_capturing && at_games_array()) {
+        _capturing = true;
+        _capture_depth = _stack.size();
+        _game = "{";
+      }
+      _stack.push_back(Level{true, true, 0, std::string()});
+      break;
+    case '[':
+      _stack.push_back(Level{false, false, 0, std::string()});
+      break;
+    case '}':
+    case ']':
+      if (_stack.empty()) {
+        error("malformed json: unbalanced brackets");
+      }
+      _stack.pop_back();
+      if (_capturing && (int)_stack.size() == _capture_depth) {
+        finish_game();
+      }
+      break;
+    case ':':
+      if (!_stack.empty() && _stack.back().is_object) {
+        _stack.back().expect_key = false;
+      }
+      break;
+    case ',':
+      if (!_stack.empty()) {
+        if (_stack.back().is_object) {
+          _stack.back().expect_key = true;
+        } else {
+          _stack.back().index++;
+        }
+      }
+      break;
     }
-    pd.height = best_height;
-    pd.width = best_width;
-    pd.url = best_url;
-    data.push_back(pd);
   }
-  return data;
-}
-
-std::list<PhotoData> parse_and_filter(const char * json_string, std::string aspect_ratio, int minimum_width) {
-  json11::Json json = parse_json(json_string);
-  return filter(json, aspect_ratio, minimum_width);
 }
@@ -1,11 +1,82 @@
+#include <functional>
 #include <string>
-#include <list>
+#include <vector>
 
-#include "PhotoData.hpp"
+#include "Catalog.hpp"
 
 #ifndef JSON_FILTER_HPP
 #define JSON_FILTER_HPP
 
-std::list<PhotoData> parse_and_filter(const char * json_string, std::string aspect_ratio, int minimum_width);
+// Appends the photos selected from the given schedule to catalog, skipping
+// games with no usable photo yet, such as those still to be played.
+// Returns false, with a warning and catalog unchanged, if the schedule
+// isn't valid JSON.
+bool parse_and_filter(const char * json_string, std::string aspect_ratio, int minimum_width, Catalog & catalog);
+
+// Of the photo's cuts with the given aspect ratio, the smallest that is at
+// least pixel_width wide, or the widest if none is. Falls back to the cut
+// selected at filter time if the photo has no cuts with that aspect ratio.
+PhotoCut select_cut(const Catalog & catalog, size_t i, const std::string & aspect_ratio, int pixel_width);
+
+// One change to a single game from the push feed: the game's new state, or
+// its removal.
+struct GameDelta {
+  std::string date;  // schedule date the game is listed under
+  long long game_pk;
+  bool removed;
+  Catalog game;      // the filtered game, unless removed
+};
+
+// Appends the delta messages in text to deltas. Messages are JSON objects,
+// one per line or back to back, each either
+//   {"date": "2018-06-10", "game": {...a game as in the schedule...}}
+// or
+//   {"date": "2018-06-10", "removed": 531060}
+// Malformed messages, and games with no usable photo yet, are skipped with
+// a warning.
+void parse_deltas(const std::string & text, std::string aspect_ratio, int minimum_width, std::vector<GameDelta> & deltas);
+
+// Resumable scanner for a schedule document. Bytes are fed in as they arrive
+// from the network; each game under dates[0].games is parsed and filtered as
+// soon as its closing brace is seen and appended to catalog, and its index is
+// handed to on_game, so callers can act on the first game before the rest of
+// the document has been downloaded.
+class ScheduleStreamParser {
+public:
+  ScheduleStreamParser(std::string aspect_ratio,
+                       int minimum_width,
+                       Catalog & catalog,
+                       std::function<void(size_t)> on_game);
+
+  void feed(const char * data, size_t size);
+  int games_seen() const { return _games_seen; }
+
+private:
+  struct Level {
+    bool is_object;
+    bool expect_key;   // objects only: next string is a key
+    int index;         // arrays only: index of the current element
+    std::string key;   // objects only: key of the current member
+  };
+
+  std::string _aspect_ratio;
+  int _minimum_width;
+  Catalog & _catalog;
+  std::function<void(size_t)> _on_game;
+
+  std::vector<Level> _stack;
+  bool _in_string;
+  bool _escaped;
+  std::string _string;   // current key, while one is being read
+  bool _capturing;       // inside a game object
+  int _capture_depth;    // stack depth at which the game object closes
+  std::string _game;     // text of the game object seen so far
+  std::string _date;     // dates[0].date, which precedes the games in the feed
+  int _games_seen;
+
+  bool at_schedule_date() const;
+  bool at_games_array() const;
+  void finish_game();
+};
 
 #endif
@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <cmath>
+
+#include "LatencyHistogram.hpp"
+
+const int LatencyHistogram::sub_bucket_bits;
+const uint64_t LatencyHistogram::sub_buckets;
+const uint64_t LatencyHistogram::max_us;
+
+LatencyHistogram::LatencyHistogram()
+  : _counts(index_of(max_us) + 1, 0), _count(0), _total_us(0), _max_us(0) {
+}
+
+// Values under 2 * sub_buckets index themselves; above that, each doubling
+// of the value is split into sub_buckets buckets.
+size_t LatencyHistogram::index_of(uint64_t us) {
+  int shift = 0;
+  while ((us >> shift) >= 2 * sub_buckets) {
+    shift++;
+  }
+  return (size_t)(sub_buckets * shift + (us >> shift));
+}
+
+uint64_t LatencyHistogram::highest_in(size_t index) {
+  if (index < 2 * sub_buckets) {
+    return index;
+  }
+  int shift = (int)(index / sub_buckets) - 1;
+  uint64_t top = index - sub_buckets * shift;
+  return ((top + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(double ms) {
+  uint64_t us = ms <= 0 ? 0 : std::min(max_us, (uint64_t)std::llround(ms * 1000));
+  _counts[index_of(us)]++;
+  _count++;
+  _total_us += us;
+  _max_us = std::max(_max_us, us);
+}
+
+void LatencyHistogram::clear() {
+  std::fill(_counts.begin(), _counts.end(), 0);
+  _count = 0;
+  _total_us = 0;
+  _max_us = 0;
+}
+
+double LatencyHistogram::mean_ms() const {
+  return _count == 0 ? 0 : _total_us / 1000.0 / _count;
+}
+
+double LatencyHistogram::percentile_ms(double fraction) const {
+  if (_count == 0) {
+    return 0;
+  }
+  uint64_t rank = std::max((uint64_t)1, (uint64_t)std::ceil(fraction * _count));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < _counts.size(); i++) {
+    seen += _counts[i];
+    if (seen >= rank) {
+      return std::min(highest_in(i), _max_us) / 1000.0;
+    }
+  }
+  return max_ms();
+}
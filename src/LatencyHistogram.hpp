@@ -0,0 +1,42 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Counts of latencies in buckets of bounded relative width, as in
+// HdrHistogram: values below 2 * sub_buckets microseconds are exact and
+// larger ones fall in buckets 1/sub_buckets of their size, so any
+// percentile is within about 1.6% however long the tail. Recording is a
+// few shifts and an increment. Not thread-safe.
+class LatencyHistogram {
+public:
+  LatencyHistogram();
+
+  void record(double ms);
+  void clear();
+
+  uint64_t count() const { return _count; }
+  double max_ms() const { return _max_us / 1000.0; }
+  double mean_ms() const;
+
+  // The latency at or under which fraction of those recorded fall, 0 to 1,
+  // reported as its bucket's upper bound.
+  double percentile_ms(double fraction) const;
+
+private:
+  static const int sub_bucket_bits = 6;
+  static const uint64_t sub_buckets = 1 << sub_bucket_bits;
+  static const uint64_t max_us = 3600ull * 1000 * 1000;  // larger values count as this
+
+  static size_t index_of(uint64_t us);
+  static uint64_t highest_in(size_t index);
+
+  std::vector<uint64_t> _counts;
+  uint64_t _count;
+  uint64_t _total_us;
+  uint64_t _max_us;
+};
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+#include "util.hpp"
+
+// Read-only memory mapping of a whole file. The mapping is not open if the
+// file is missing, empty or can't be mapped.
+class MappedFile : Uncopyable {
+private:
+  const char * _data;
+  size_t _size;
+
+public:
+  explicit MappedFile(const std::string & filename);
+  ~MappedFile();
+
+  bool is_open() const { return _data != nullptr; }
+  const char * data() const { return _data; }
+  size_t size() const { return _size; }
+};
+
+#endif
@@ -9,6 +9,27 @@
 #ifndef PHOTO_DATA_HPP
 #define PHOTO_DATA_HPP
 
+#include <string>
+#include <vector>
+
+// One of the sizes a photo is offered in.
+struct PhotoCut {
+  std::string aspect_ratio;
+  std::string url;
+  int width;
+  int height;
+};
+
+// The game a photo belongs to.
+struct GameInfo {
+  long long game_pk;      // the feed's id for the game
+  std::string date;       // official date, YYYY-MM-DD
+  std::string time;       // start time, ISO 8601 UTC as in the feed
+  std::string away_team;
+  std::string home_team;
+  std::string venue;
+};
+
 // Representation of one photo.
 struct PhotoData {
   std::string headline;
@@ -16,6 +37,25 @@ struct PhotoData {
   std::string url;
   int width;
   int height;
+  std::vector<PhotoCut> cuts;  // every cut in the feed, selected or not
+  GameInfo game;
 };
 
+inline bool operator==(const PhotoCut & a, const PhotoCut & b) {
+  return a.aspect_ratio == b.aspect_ratio && a.url == b.url
+    && a.width == b.width && a.height == b.height;
+}
+
+inline bool operator==(const GameInfo & a, const GameInfo & b) {
+  return a.game_pk == b.game_pk && a.date == b.date && a.time == b.time
+    && a.away_team == b.away_team
+    && a.home_team == b.home_team && a.venue == b.venue;
+}
+
+inline bool operator==(const PhotoData & a, const PhotoData & b) {
+  return a.headline == b.headline && a.subhead == b.subhead && a.url == b.url
+    && a.width == b.width && a.height == b.height && a.cuts == b.cuts
+    && a.game == b.game;
+}
+
 #endif
@@ -0,0 +1,24 @@
+#ifndef PHOTO_SIZES_HPP
+#define PHOTO_SIZES_HPP
+
+// Which photos PhotoList asks for and the sizes it draws them at, shared
+// with the pipeline benchmark so it times the same work.
+
+// Choose the smallest photos at least this width in pixels
+const int minimum_width = 400;
+
+// Set aspect ratio here
+static const char * const aspect_ratio_string = "16:9";
+inline int box_height_for_width(int width) {
+  return width * 9 / 16;
+}
+
+// Width of a box either side of the focused one
+const int box_width = 300;
+
+// Set scale factor of focused box here
+inline int scale_fbox(int x) {
+  return x * 3 / 2;
+}
+
+#endif
@@ -0,0 +1,31 @@
+#include "Resource.hpp"
+
+Resource::Resource(const std::string & filename) : _filename(filename), _file(filename) {
+  if (!_file.is_open()) {
+    error(("couldn't map " + _filename).c_str());
+  }
+}
+
+SDL_RWops * Resource::open() const {
+  SDL_RWops * source = SDL_RWFromConstMem(_file.data(), _file.size());
+  if (source == nullptr) {
+    error("Couldn't get SDL_RWops");
+  }
+  return source;
+}
+
+SDL_Surface * Resource::load_image() const {
+  SDL_Surface * image = IMG_Load_RW(open(), 1 /* free source after use */);
+  if (image == nullptr) {
+    error(("couldn't load " + _filename).c_str());
+  }
+  return image;
+}
+
+TTF_Font * Resource::open_font(int point_size) const {
+  TTF_Font * font = TTF_OpenFontRW(open(), 1 /* free source on close */, point_size);
+  if (font == nullptr) {
+    error(("couldn't open font " + _filename).c_str());
+  }
+  return font;
+}
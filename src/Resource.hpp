@@ -0,0 +1,35 @@
+#ifndef RESOURCE_HPP
+#define RESOURCE_HPP
+
+#include <string>
+
+#include "SDL.h"
+#include "SDL_image.h"
+#include "SDL_ttf.h"
+
+#include "MappedFile.hpp"
+#include "util.hpp"
+
+// An asset file, mapped once and read by SDL straight out of the mapping
+// instead of through stdio. Every font or image opened from it shares the
+// mapping, so it must outlive them. A missing asset is fatal.
+class Resource : Uncopyable {
+private:
+  std::string _filename;
+  MappedFile _file;
+
+  SDL_RWops * open() const;
+
+public:
+  explicit Resource(const std::string & filename);
+
+  size_t size() const { return _file.size(); }
+
+  // Decodes the asset; the surface doesn't refer to the mapping.
+  SDL_Surface * load_image() const;
+
+  // The font keeps reading glyphs out of the mapping while it is open.
+  TTF_Font * open_font(int point_size) const;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include <chrono>
+#include <utility>
+
+#include "CatalogCache.hpp"
+#include "Download.hpp"
+#include "JsonFilter.hpp"
+#include "ScheduleRefresher.hpp"
+
+ScheduleRefresher::ScheduleRefresher(FeedSet & feeds,
+                                     std::string aspect_ratio,
+                                     int minimum_width,
+                                     int interval_seconds)
+  : _feeds(feeds),
+    _aspect_ratio(aspect_ratio),
+    _minimum_width(minimum_width),
+    _interval_seconds(interval_seconds),
+    _stopping(false),
+    _poll_requested(false),
+    _periodic(true) {
+  _thread = std::thread(&ScheduleRefresher::run, this);
+}
+
+ScheduleRefresher::~ScheduleRefresher() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _wake.notify_all();
+  _thread.join();
+}
+
+void ScheduleRefresher::watch(const std::vector<std::string> & dates) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _dates = dates;
+  std::map<std::string, Validators> kept;
+  for (const std::string & date : dates) {
+    for (size_t f = 0; f < _feeds.size(); f++) {
+      std::string url = _feeds.url(f, date);
+      kept[url] = _validators[url];
+    }
+  }
+  _validators.swap(kept);
+}
+
+void ScheduleRefresher::poll_now() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _poll_requested = true;
+  }
+  _wake.notify_all();
+}
+
+void ScheduleRefresher::set_periodic(bool periodic) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _periodic = periodic;
+  }
+  _wake.notify_all();
+}
+
+// Requests are made without holding the lock, so the main thread never
+// waits on the network.
+void ScheduleRefresher::run() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true) {
+    bool timed_out = !_wake.wait_for(lock,
+                                     std::chrono::seconds(_interval_seconds),
+                                     [this] { return _stopping || _poll_requested; });
+    if (_stopping) {
+      return;
+    }
+    if (timed_out && !_periodic) {
+      continue;
+    }
+    _poll_requested = false;
+    std::vector<std::string> dates = _dates;
+    lock.unlock();
+    for (const std::string & date : dates) {
+      for (size_t f = 0; f < _feeds.size(); f++) {
+        poll(date, f);
+      }
+    }
+    lock.lock();
+  }
+}
+
+void ScheduleRefresher::poll(const std::string & date, size_t feed) {
+  std::string url = _feeds.url(feed, date);
+  Validators validators;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto found = _validators.find(url);
+    if (_stopping || found == _validators.end()) {
+      return;
+    }
+    validators = found->second;
+  }
+  ConditionalFetch response = fetch_if_modified(url, validators.etag, validators.last_modified);
+  if (!response.ok) {
+    return;  // try again next interval
+  }
+
+  Catalog games;
+  if (!response.not_modified) {
+    if (!parse_and_filter(response.body.c_str(), _aspect_ratio, _minimum_width, games)) {
+      warning(("keeping the shown games; couldn't parse refreshed " + url).c_str());
+      return;  // validators unchanged, so the next poll fetches it again
+    }
+    CatalogCache(url, _aspect_ratio, _minimum_width).save(games);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto found = _validators.find(url);
+    if (found == _validators.end()) {
+      return;  // no longer watched
+    }
+    found->second.etag = response.etag;
+    found->second.last_modified = response.last_modified;
+  }
+  if (!response.not_modified) {
+    _feeds.update(date, feed, std::move(games));
+  }
+}
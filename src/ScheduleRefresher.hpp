@@ -0,0 +1,65 @@
+#ifndef SCHEDULE_REFRESHER_HPP
+#define SCHEDULE_REFRESHER_HPP
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FeedSet.hpp"
+#include "util.hpp"
+
+// Background poller that keeps the shown schedule dates current while games
+// are played. Every interval, each watched date's feeds are requested
+// conditionally, so an unchanged feed costs a 304. A changed feed is parsed
+// and filtered on the poller's thread, saved to the catalog cache and handed
+// to the feed set, which queues the date's new merged catalog for the main
+// thread.
+class ScheduleRefresher : Uncopyable {
+public:
+  ScheduleRefresher(FeedSet & feeds,
+                    std::string aspect_ratio,
+                    int minimum_width,
+                    int interval_seconds);
+  // Waits for a request in flight, if any.
+  ~ScheduleRefresher();
+
+  // Replaces the dates to poll. Validators of feeds on dates still watched
+  // are kept; the others are dropped.
+  void watch(const std::vector<std::string> & dates);
+
+  // Poll the watched dates now rather than at the end of the interval.
+  void poll_now();
+
+  // Whether to poll every interval. When off, as when changes are pushed,
+  // dates are only polled on poll_now.
+  void set_periodic(bool periodic);
+
+private:
+  struct Validators {
+    std::string etag;
+    std::string last_modified;
+  };
+
+  FeedSet & _feeds;
+  std::string _aspect_ratio;
+  int _minimum_width;
+  int _interval_seconds;
+
+  std::mutex _mutex;  // guards everything below
+  std::condition_variable _wake;
+  bool _stopping;
+  bool _poll_requested;
+  bool _periodic;
+  std::vector<std::string> _dates;
+  std::map<std::string, Validators> _validators;  // by url
+
+  std::thread _thread;  // started last
+
+  void run();
+  void poll(const std::string & date, size_t feed);
+};
+
+#endif
@@ -0,0 +1,148 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#include <sys/stat.h>
+
+#include "ScriptedRun.hpp"
+
+// Frames are compared in one format whatever the window's was.
+static const Uint32 compare_pixel_format = SDL_PIXELFORMAT_RGB888;
+
+static bool read_count(const std::string & digits, Uint32 & count) {
+  if (digits.empty() || digits.find_first_not_of("0123456789") != std::string::npos) {
+    return false;
+  }
+  count = strtoul(digits.c_str(), nullptr, 10);
+  return true;
+}
+
+static bool read_keycode(const std::string & name, SDL_Keycode & keycode) {
+  if (name == "right") {
+    keycode = SDLK_RIGHT;
+  } else if (name == "left") {
+    keycode = SDLK_LEFT;
+  } else if (name == "slash") {
+    keycode = SDLK_SLASH;
+  } else if (name == "return") {
+    keycode = SDLK_RETURN;
+  } else if (name == "escape") {
+    keycode = SDLK_ESCAPE;
+  } else if (name == "backspace") {
+    keycode = SDLK_BACKSPACE;
+  } else if (name.size() == 1 && name[0] >= 'a' && name[0] <= 'z') {
+    keycode = name[0];
+  } else {
+    return false;
+  }
+  return true;
+}
+
+std::vector<ScriptStep> read_script(const std::string & filename) {
+  std::ifstream in(filename);
+  if (!in) {
+    error(("couldn't open script " + filename).c_str());
+  }
+  std::vector<ScriptStep> steps;
+  std::string word;
+  while (in >> word) {
+    if (word[0] == '#') {
+      std::getline(in, word);
+      continue;
+    }
+    ScriptStep step{ScriptStep::press, SDLK_UNKNOWN, std::string(), 0};
+    Uint32 repeat = 1;
+    bool valid = true;
+    if (word.compare(0, 5, "type:") == 0) {
+      step.kind = ScriptStep::type;
+      step.text = word.substr(5);
+      valid = !step.text.empty();
+    } else if (word.compare(0, 5, "wait:") == 0) {
+      step.kind = ScriptStep::wait;
+      valid = read_count(word.substr(5), step.ms);
+    } else if (word == "settle") {
+      step.kind = ScriptStep::settle;
+    } else if (word == "shot") {
+      step.kind = ScriptStep::shot;
+    } else {
+      size_t star = word.find('*');
+      valid = read_keycode(word.substr(0, star), step.keycode)
+        && (star == std::string::npos || read_count(word.substr(star + 1), repeat));
+    }
+    if (!valid) {
+      error(("bad step in script: " + word).c_str());
+    }
+    steps.insert(steps.end(), repeat, step);
+  }
+  return steps;
+}
+
+ShotRecorder::ShotRecorder(const std::string & dump_dir, const std::string & golden_dir)
+  : _dump_dir(dump_dir), _golden_dir(golden_dir), _shots(0), _mismatches(0) {
+  if (!_dump_dir.empty() && mkdir(_dump_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+    error(("couldn't create dump directory " + _dump_dir).c_str());
+  }
+}
+
+void ShotRecorder::shoot(SDL_Surface * frame) {
+  char name[32];
+  snprintf(name, sizeof(name), "shot-%02d.bmp", ++_shots);
+  SDL_Surface * shot = SDL_ConvertSurfaceFormat(frame, compare_pixel_format, 0);
+  if (shot == nullptr) {
+    error("couldn't convert frame for comparison");
+  }
+  if (!_dump_dir.empty() && SDL_SaveBMP(shot, (_dump_dir + "/" + name).c_str()) != 0) {
+    warning((std::string("couldn't save ") + name).c_str());
+  }
+  if (_golden_dir.empty()) {
+    SDL_FreeSurface(shot);
+    return;
+  }
+
+  SDL_Surface * loaded = SDL_LoadBMP((_golden_dir + "/" + name).c_str());
+  SDL_Surface * golden = loaded == nullptr ? nullptr : SDL_ConvertSurfaceFormat(loaded, compare_pixel_format, 0);
+  std::string note;
+  if (golden == nullptr) {
+    note = "no golden image";
+  } else if (golden->w != shot->w || golden->h != shot->h) {
+    note = "golden image is " + std::to_string(golden->w) + "x" + std::to_string(golden->h)
+      + ", frame is " + std::to_string(shot->w) + "x" + std::to_string(shot->h);
+  } else {
+    long differing = 0;
+    SDL_LockSurface(shot);
+    SDL_LockSurface(golden);
+    for (int y = 0; y < shot->h; y++) {
+      const Uint32 * a = (const Uint32 *)((const Uint8 *)shot->pixels + y * shot->pitch);
+      const Uint32 * b = (const Uint32 *)((const Uint8 *)golden->pixels + y * golden->pitch);
+      for (int x = 0; x < shot->w; x++) {
+        differing += ((a[x] ^ b[x]) & 0xffffff) != 0;
+      }
+    }
+    SDL_UnlockSurface(golden);
+    SDL_UnlockSurface(shot);
+    if (differing > 0) {
+      note = std::to_string(differing) + " of " + std::to_string((long)shot->w * shot->h)
+        + " pixels differ";
+    }
+  }
+  if (!note.empty()) {
+    _mismatches++;
+    _notes.push_back(std::string(name) + ": " + note);
+  }
+  for (SDL_Surface * surface : {loaded, golden, shot}) {
+    if (surface != nullptr) {
+      SDL_FreeSurface(surface);
+    }
+  }
+}
+
+bool ShotRecorder::report(std::ostream & out) const {
+  for (const std::string & note : _notes) {
+    out << "mismatch: " << note << std::endl;
+  }
+  if (!_golden_dir.empty()) {
+    out << _shots - _mismatches << " of " << _shots << " shots match " << _golden_dir << std::endl;
+  }
+  return _mismatches == 0;
+}
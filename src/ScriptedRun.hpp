@@ -0,0 +1,51 @@
+#ifndef SCRIPTED_RUN_HPP
+#define SCRIPTED_RUN_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "SDL.h"
+
+#include "util.hpp"
+
+// A navigation sequence to play without anyone at the keyboard, for
+// benchmarks and for checking what's drawn against known-good images.
+// Scripts are whitespace-separated steps, with # starting a comment:
+//   right, left, slash, return, escape, backspace or a single letter
+//                press that key; a suffix *N presses it N times
+//   type:TEXT    text input, as if typed into the search field
+//   wait:MS      let the app run for MS milliseconds
+//   settle       wait until nothing is animating or loading
+//   shot         settle, then save the frame on screen
+struct ScriptStep {
+  enum Kind { press, type, wait, settle, shot };
+  Kind kind;
+  SDL_Keycode keycode;
+  std::string text;
+  Uint32 ms;
+};
+
+std::vector<ScriptStep> read_script(const std::string & filename);
+
+// Saves the frames shot during a scripted run as shot-NN.bmp in a dump
+// directory and compares each with the file of the same name in a golden
+// directory, either of which may be empty to skip that part.
+class ShotRecorder : Uncopyable {
+private:
+  std::string _dump_dir;
+  std::string _golden_dir;
+  int _shots;
+  int _mismatches;
+  std::vector<std::string> _notes;
+
+public:
+  ShotRecorder(const std::string & dump_dir, const std::string & golden_dir);
+
+  void shoot(SDL_Surface * frame);
+
+  // Prints what didn't match; true if everything did.
+  bool report(std::ostream & out) const;
+};
+
+#endif
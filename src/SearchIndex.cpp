@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cctype>
+
+#include "SearchIndex.hpp"
+
+static char fold(char c) {
+  return tolower((unsigned char)c);
+}
+
+static std::string fold(const std::string & s) {
+  std::string folded(s);
+  std::transform(folded.begin(), folded.end(), folded.begin(),
+                 [](char c) { return fold(c); });
+  return folded;
+}
+
+// Trigrams of folded text.
+static uint32_t trigram(const char * p) {
+  return (uint32_t)(unsigned char)p[0] << 16
+    | (uint32_t)(unsigned char)p[1] << 8
+    | (unsigned char)p[2];
+}
+
+void SearchIndex::clear() {
+  _postings.clear();
+  _folded.clear();
+  _starts.clear();
+  _indexed = 0;
+  _last_query.clear();
+  _last_results.clear();
+}
+
+void SearchIndex::sync(const Catalog & catalog) {
+  if (_indexed == catalog.size()) {
+    return;
+  }
+  for (size_t i = _indexed; i < catalog.size(); i++) {
+    _starts.push_back(_folded.size());
+    for (TextRef ref : {catalog.headline_ref(i), catalog.subhead_ref(i)}) {
+      size_t begin = _folded.size();
+      const char * text = catalog.text(ref);
+      for (size_t k = 0; k < ref.length; k++) {
+        _folded += fold(text[k]);
+      }
+      // trigrams don't span the separator, so headline and subhead match
+      // separately, as they do when checking candidates
+      for (size_t k = begin; k + 3 <= _folded.size(); k++) {
+        std::vector<uint32_t> & list = _postings[trigram(_folded.data() + k)];
+        // photos are indexed in order, so a repeat is always at the back
+        if (list.empty() || list.back() != i) {
+          list.push_back(i);
+        }
+      }
+      _folded += '\n';
+    }
+  }
+  _indexed = catalog.size();
+  _last_query.clear();
+  _last_results.clear();
+}
+
+bool SearchIndex::matches(size_t i, const std::string & folded_query) const {
+  const char * begin = _folded.data() + _starts[i];
+  const char * end = i + 1 < _starts.size() ? _folded.data() + _starts[i + 1] : _folded.data() + _folded.size();
+  return std::search(begin, end, folded_query.begin(), folded_query.end()) != end;
+}
+
+// One pass over all the folded text, for queries that would match too many
+// photos for trigrams to narrow them down.
+void SearchIndex::scan(const std::string & folded_query, std::vector<uint32_t> & results) const {
+  size_t pos = _folded.find(folded_query);
+  size_t i = 0;
+  while (pos != std::string::npos) {
+    // hits come in order, so the photo containing each is found by walking
+    while (i + 1 < _starts.size() && _starts[i + 1] <= pos) {
+      i++;
+    }
+    results.push_back(i);
+    if (i + 1 == _starts.size()) {
+      break;
+    }
+    pos = _folded.find(folded_query, _starts[i + 1]);
+  }
+}
+
+const std::vector<uint32_t> & SearchIndex::search(const Catalog & catalog,
+                                                  const std::string & query) {
+  std::string q = fold(query);
+  std::vector<uint32_t> candidates;
+  bool extends_last = !_last_query.empty()
+    && q.size() >= _last_query.size()
+    && q.compare(0, _last_query.size(), _last_query) == 0;
+  _last_query = q;
+
+  if (q.empty()) {
+    _last_results.resize(catalog.size());
+    for (size_t i = 0; i < _last_results.size(); i++) {
+      _last_results[i] = i;
+    }
+    return _last_results;
+  }
+
+  if (q.size() >= 3) {
+    // intersect posting lists, shortest first
+    std::vector<const std::vector<uint32_t> *> lists;
+    for (size_t k = 0; k + 3 <= q.size(); k++) {
+      auto found = _postings.find(trigram(q.data() + k));
+      if (found == _postings.end()) {
+        _last_results.clear();
+        return _last_results;
+      }
+      lists.push_back(&found->second);
+    }
+    std::sort(lists.begin(), lists.end(),
+              [](const std::vector<uint32_t> * a, const std::vector<uint32_t> * b) {
+                return a->size() < b->size();
+              });
+    candidates = *lists[0];
+    for (size_t l = 1; l < lists.size() && !candidates.empty(); l++) {
+      std::vector<uint32_t> both;
+      std::set_intersection(candidates.begin(), candidates.end(),
+                            lists[l]->begin(), lists[l]->end(),
+                            std::back_inserter(both));
+      candidates.swap(both);
+    }
+    if (q.size() == 3) {
+      // the trigram itself is the query
+      _last_results.swap(candidates);
+      return _last_results;
+    }
+    if (extends_last && _last_results.size() < candidates.size()) {
+      candidates.swap(_last_results);
+    }
+  } else if (extends_last) {
+    candidates.swap(_last_results);
+  } else {
+    _last_results.clear();
+    scan(q, _last_results);
+    return _last_results;
+  }
+
+  // longer queries: trigrams can match in the wrong order
+  _last_results.clear();
+  if (candidates.size() > _starts.size() / 4) {
+    scan(q, _last_results);
+  } else {
+    for (uint32_t i : candidates) {
+      if (matches(i, q)) {
+        _last_results.push_back(i);
+      }
+    }
+  }
+  return _last_results;
+}
@@ -0,0 +1,48 @@
+#ifndef SEARCH_INDEX_HPP
+#define SEARCH_INDEX_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Catalog.hpp"
+
+// Trigram index over the headlines and subheads of a catalog, for
+// case-insensitive substring search as the user types. Each trigram maps to
+// the sorted indices of the photos containing it; a query intersects the
+// lists of its trigrams and checks the candidates left against a case-folded
+// copy of the text. Queries too short for trigrams scan the folded text in
+// one pass. Matching is ASCII case-insensitive; other bytes must match
+// exactly.
+class SearchIndex {
+private:
+  std::unordered_map<uint32_t, std::vector<uint32_t>> _postings;
+  std::string _folded;           // per photo: headline, '\n', subhead, '\n'
+  std::vector<uint32_t> _starts;  // offset of each photo's text in _folded
+  size_t _indexed;  // photos [0, _indexed) are indexed
+
+  bool matches(size_t i, const std::string & folded_query) const;
+  void scan(const std::string & folded_query, std::vector<uint32_t> & results) const;
+
+  // Results of the previous query. A query that extends it only needs to
+  // check these.
+  std::string _last_query;
+  std::vector<uint32_t> _last_results;
+
+public:
+  SearchIndex() : _indexed(0) {}
+
+  // Forget everything. Needed whenever photos are changed, removed or
+  // inserted anywhere but the end of the catalog.
+  void clear();
+
+  // Index photos appended to the catalog since the last sync.
+  void sync(const Catalog & catalog);
+
+  // Indices of photos whose headline or subhead contains query, in catalog
+  // order. The catalog must be synced.
+  const std::vector<uint32_t> & search(const Catalog & catalog, const std::string & query);
+};
+
+#endif
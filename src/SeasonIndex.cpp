@@ -0,0 +1,152 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <utility>
+
+#include "Date.hpp"
+#include "Download.hpp"
+#include "JsonFilter.hpp"
+#include "SeasonIndex.hpp"
+#include "ThreadPool.hpp"
+
+SeasonIndex::SeasonIndex(std::string first_date,
+                         std::string last_date,
+                         std::string aspect_ratio,
+                         int minimum_width,
+                         std::function<std::string(const std::string &)> url_for_date)
+  : _first_date(first_date),
+    _last_date(last_date),
+    _aspect_ratio(aspect_ratio),
+    _minimum_width(minimum_width),
+    _url_for_date(url_for_date),
+    _merged("season:" + url_for_date(first_date) + ".." + last_date, aspect_ratio, minimum_width) {
+  _manifest_path = _merged.path() + ".manifest";
+}
+
+// One line per date: date, ETag, Last-Modified and game count, tab
+// separated. Validators may be empty.
+std::vector<SeasonIndex::DateEntry> SeasonIndex::read_manifest() const {
+  std::vector<DateEntry> dates;
+  std::ifstream in(_manifest_path);
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream fields(line);
+    DateEntry entry;
+    std::string count;
+    std::getline(fields, entry.date, '\t');
+    std::getline(fields, entry.etag, '\t');
+    std::getline(fields, entry.last_modified, '\t');
+    std::getline(fields, count, '\t');
+    entry.count = strtoul(count.c_str(), nullptr, 10);
+    dates.push_back(entry);
+  }
+  return dates;
+}
+
+void SeasonIndex::write_manifest(const std::vector<DateEntry> & dates) const {
+  std::string tmp_path = _manifest_path + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::trunc);
+    for (const DateEntry & entry : dates) {
+      out << entry.date << '\t' << entry.etag << '\t'
+          << entry.last_modified << '\t' << entry.count << '\n';
+    }
+    if (!out) {
+      warning("couldn't write season index manifest");
+      return;
+    }
+  }
+  if (rename(tmp_path.c_str(), _manifest_path.c_str()) != 0) {
+    warning("couldn't replace season index manifest");
+  }
+}
+
+SeasonIndex::UpdateStats SeasonIndex::update(int n_threads) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  std::map<std::string, DateEntry> previous;
+  for (const DateEntry & entry : read_manifest()) {
+    previous[entry.date] = entry;
+  }
+
+  std::vector<DateEntry> dates;
+  for (std::string date = _first_date; date <= _last_date; date = add_days(date, 1)) {
+    DateEntry entry = previous.count(date) ? previous[date] : DateEntry{date, "", "", 0};
+    dates.push_back(entry);
+  }
+
+  UpdateStats stats = {0, 0, 0, 0, 0};
+  std::mutex stats_mutex;
+  std::vector<Catalog> catalogs(dates.size());
+  {
+    ThreadPool pool(n_threads);
+    for (size_t i = 0; i < dates.size(); i++) {
+      pool.submit([&, i] {
+        DateEntry & entry = dates[i];
+        std::string url = _url_for_date(entry.date);
+        CatalogCache cache(url, _aspect_ratio, _minimum_width);
+
+        ConditionalFetch response = fetch_if_modified(url, entry.etag, entry.last_modified);
+        if (response.ok && response.not_modified && cache.load(catalogs[i])) {
+          std::lock_guard<std::mutex> lock(stats_mutex);
+          stats.not_modified++;
+          return;
+        }
+        if (response.ok && response.not_modified) {
+          // validators match but the date's cache is gone
+          response = fetch_if_modified(url, "", "");
+        }
+        if (!response.ok
+            || !parse_and_filter(response.body.c_str(), _aspect_ratio, _minimum_width, catalogs[i])) {
+          entry.etag.clear();
+          entry.last_modified.clear();
+          cache.load(catalogs[i]);
+          std::lock_guard<std::mutex> lock(stats_mutex);
+          stats.failed++;
+          return;
+        }
+        cache.save(catalogs[i]);
+        entry.etag = response.etag;
+        entry.last_modified = response.last_modified;
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        stats.fetched++;
+      });
+    }
+    pool.wait();
+  }
+
+  // dates are already in order, and games within a date in feed order
+  Catalog merged;
+  for (size_t i = 0; i < dates.size(); i++) {
+    dates[i].count = catalogs[i].size();
+    merged.append(catalogs[i]);
+  }
+  _merged.save(merged);
+  write_manifest(dates);
+
+  stats.games = merged.size();
+  stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return stats;
+}
+
+bool SeasonIndex::load(Catalog & catalog, std::vector<DateEntry> & dates) const {
+  std::vector<DateEntry> manifest = read_manifest();
+  Catalog merged;
+  if (manifest.empty() || !_merged.load(merged)) {
+    return false;
+  }
+  size_t total = 0;
+  for (const DateEntry & entry : manifest) {
+    total += entry.count;
+  }
+  if (total != merged.size()) {
+    return false;  // manifest and merged catalog from different updates
+  }
+  catalog = std::move(merged);
+  dates = manifest;
+  return true;
+}
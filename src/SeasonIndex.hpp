@@ -0,0 +1,61 @@
+#ifndef SEASON_INDEX_HPP
+#define SEASON_INDEX_HPP
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Catalog.hpp"
+#include "CatalogCache.hpp"
+#include "util.hpp"
+
+// Catalog of every schedule date in a range. Dates are fetched and parsed
+// concurrently on a thread pool and merged in date order. On disk the index
+// is the merged catalog, one catalog cache per date, and a manifest of each
+// date's HTTP validators, so an update downloads only the dates whose
+// schedule changed.
+class SeasonIndex : Uncopyable {
+public:
+  struct DateEntry {
+    std::string date;
+    std::string etag;
+    std::string last_modified;
+    size_t count;  // games on this date
+  };
+
+  struct UpdateStats {
+    int fetched;       // downloaded and parsed
+    int not_modified;  // validators matched, per-date cache reused
+    int failed;        // fetch or parse failed; stale or no games kept
+    size_t games;
+    double seconds;
+  };
+
+  SeasonIndex(std::string first_date,
+              std::string last_date,
+              std::string aspect_ratio,
+              int minimum_width,
+              std::function<std::string(const std::string &)> url_for_date);
+
+  // Brings the index up to date with the feed, fetching with n_threads
+  // concurrent transfers.
+  UpdateStats update(int n_threads);
+
+  // Loads the merged catalog and the per-date counts. Returns false if the
+  // index hasn't been built.
+  bool load(Catalog & catalog, std::vector<DateEntry> & dates) const;
+
+private:
+  std::string _first_date;
+  std::string _last_date;
+  std::string _aspect_ratio;
+  int _minimum_width;
+  std::function<std::string(const std::string &)> _url_for_date;
+  CatalogCache _merged;
+  std::string _manifest_path;
+
+  std::vector<DateEntry> read_manifest() const;
+  void write_manifest(const std::vector<DateEntry> & dates) const;
+};
+
+#endif
@@ -0,0 +1,171 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <sys/stat.h>
+
+#include "SessionSnapshot.hpp"
+
+static const char session_magic[8] = {'P', 'L', 'S', 'E', 'S', 'S', 'N', '\0'};
+// Bump whenever the layout below changes; older files are then ignored.
+static const uint32_t session_version = 1;
+static const Uint32 session_pixel_format = SDL_PIXELFORMAT_ARGB8888;
+// Pixel blocks start on cache line boundaries.
+static const size_t pixels_alignment = 64;
+
+struct SessionHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t box_count;
+  int64_t focused_game_pk;
+  uint32_t key_size;
+  uint32_t date_size;
+};
+
+// Followed by the key and date text, then the pixel blocks.
+struct SessionImage {
+  int64_t game_pk;
+  uint64_t pixels_offset;
+  uint32_t width;
+  uint32_t height;
+  uint32_t pitch;
+  uint32_t reserved;
+};
+
+static size_t aligned(size_t offset) {
+  return (offset + pixels_alignment - 1) / pixels_alignment * pixels_alignment;
+}
+
+void save_session(const std::string & path, const SessionState & state) {
+  std::vector<SDL_Surface *> images;
+  images.push_back(SDL_ConvertSurfaceFormat(state.frame, session_pixel_format, 0));
+  for (auto & box : state.boxes) {
+    images.push_back(SDL_ConvertSurfaceFormat(box.second, session_pixel_format, 0));
+  }
+
+  SessionHeader header;
+  memcpy(header.magic, session_magic, sizeof(header.magic));
+  header.version = session_version;
+  header.box_count = state.boxes.size();
+  header.focused_game_pk = state.focused_game_pk;
+  header.key_size = state.key.size();
+  header.date_size = state.date.size();
+
+  std::vector<SessionImage> records(images.size());
+  size_t offset = aligned(sizeof(header) + records.size() * sizeof(SessionImage)
+                          + state.key.size() + state.date.size());
+  bool converted = true;
+  for (size_t i = 0; i < images.size(); i++) {
+    converted = converted && images[i] != nullptr;
+    records[i].game_pk = i == 0 ? 0 : state.boxes[i - 1].first;
+    records[i].reserved = 0;
+    if (images[i] != nullptr) {
+      records[i].pixels_offset = offset;
+      records[i].width = images[i]->w;
+      records[i].height = images[i]->h;
+      records[i].pitch = images[i]->pitch;
+      offset = aligned(offset + (size_t)images[i]->pitch * images[i]->h);
+    }
+  }
+
+  bool written = false;
+  std::string tmp_path = path + ".tmp";
+  std::string directory = path.substr(0, path.rfind('/'));
+  if (!converted) {
+    warning("couldn't convert session images");
+  } else if (directory != path && mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+    warning("couldn't create session directory");
+  } else {
+    // write to the side and rename, so a reader never maps a partial file
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    out.write((const char *)&header, sizeof(header));
+    out.write((const char *)records.data(), records.size() * sizeof(SessionImage));
+    out.write(state.key.data(), state.key.size());
+    out.write(state.date.data(), state.date.size());
+    for (size_t i = 0; i < images.size(); i++) {
+      std::string padding(records[i].pixels_offset - out.tellp(), '\0');
+      out.write(padding.data(), padding.size());
+      SDL_LockSurface(images[i]);
+      out.write((const char *)images[i]->pixels, (size_t)images[i]->pitch * images[i]->h);
+      SDL_UnlockSurface(images[i]);
+    }
+    written = (bool)out;
+    if (!written) {
+      warning("couldn't write session");
+    }
+  }
+  for (SDL_Surface * image : images) {
+    if (image != nullptr) {
+      SDL_FreeSurface(image);
+    }
+  }
+  if (written && rename(tmp_path.c_str(), path.c_str()) != 0) {
+    warning("couldn't replace session");
+  }
+}
+
+SavedSession::SavedSession(const std::string & path, const std::string & key)
+  : _file(path), _valid(false), _focused_game_pk(0), _images(nullptr), _box_count(0) {
+  if (!_file.is_open() || _file.size() < sizeof(SessionHeader)) {
+    return;
+  }
+  const SessionHeader * header = (const SessionHeader *)_file.data();
+  if (memcmp(header->magic, session_magic, sizeof(session_magic)) != 0
+      || header->version != session_version) {
+    return;
+  }
+  size_t records_end = sizeof(SessionHeader) + ((size_t)header->box_count + 1) * sizeof(SessionImage);
+  if (records_end > _file.size()
+      || (size_t)header->key_size + header->date_size > _file.size() - records_end) {
+    return;
+  }
+  const SessionImage * images = (const SessionImage *)(header + 1);
+  const char * text = (const char *)(images + header->box_count + 1);
+  if (std::string(text, header->key_size) != key) {
+    return;
+  }
+  for (uint32_t i = 0; i <= header->box_count; i++) {
+    const SessionImage & image = images[i];
+    if (image.width == 0 || image.height == 0
+        || image.pitch < (uint64_t)image.width * 4
+        || image.pixels_offset % pixels_alignment != 0
+        || image.pixels_offset > _file.size()
+        || (uint64_t)image.pitch * image.height > _file.size() - image.pixels_offset) {
+      return;
+    }
+  }
+  _date.assign(text + header->key_size, header->date_size);
+  _focused_game_pk = header->focused_game_pk;
+  _images = images;
+  _box_count = header->box_count;
+  _valid = true;
+}
+
+// The mapping is read-only, but blits only read from their source.
+SDL_Surface * SavedSession::view(const SessionImage & image) const {
+  return SDL_CreateRGBSurfaceWithFormatFrom((void *)(_file.data() + image.pixels_offset),
+                                            image.width,
+                                            image.height,
+                                            32,
+                                            image.pitch,
+                                            session_pixel_format);
+}
+
+SDL_Surface * SavedSession::frame() const {
+  return _valid ? view(_images[0]) : nullptr;
+}
+
+int64_t SavedSession::box_game_pk(size_t i) const {
+  return _images[1 + i].game_pk;
+}
+
+SDL_Surface * SavedSession::box(size_t i) const {
+  SDL_Surface * mapped = view(_images[1 + i]);
+  if (mapped == nullptr) {
+    return nullptr;
+  }
+  SDL_Surface * copy = SDL_DuplicateSurface(mapped);
+  SDL_FreeSurface(mapped);
+  return copy;
+}
@@ -0,0 +1,62 @@
+#ifndef SESSION_SNAPSHOT_HPP
+#define SESSION_SNAPSHOT_HPP
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "SDL.h"
+
+#include "MappedFile.hpp"
+#include "util.hpp"
+
+// What was on screen, saved so a relaunch can put it straight back up and
+// revalidate afterwards instead of starting from a black screen. The file is
+// a fixed-layout header, one record per image and the images' pixels in
+// 32-bit ARGB, so it is used straight out of a read-only mapping.
+struct SessionState {
+  std::string key;             // launch options the session belongs to
+  std::string date;            // schedule date of the focused game
+  int64_t focused_game_pk;
+  SDL_Surface * frame;         // the window as last drawn
+  std::vector<std::pair<int64_t, SDL_Surface *>> boxes;  // displayed photos by game id
+};
+
+// Replaces the session file with state. Surfaces may be in any format and
+// are not freed. Failures are reported but not fatal.
+void save_session(const std::string & path, const SessionState & state);
+
+struct SessionImage;
+
+// A session file mapped for reading. Not valid if the file is missing,
+// malformed, or saved under another key.
+class SavedSession : Uncopyable {
+private:
+  MappedFile _file;
+  bool _valid;
+  std::string _date;
+  int64_t _focused_game_pk;
+  const SessionImage * _images;  // the frame, then the boxes
+  size_t _box_count;
+
+  SDL_Surface * view(const SessionImage & image) const;
+
+public:
+  SavedSession(const std::string & path, const std::string & key);
+
+  bool is_valid() const { return _valid; }
+  const std::string & date() const { return _date; }
+  int64_t focused_game_pk() const { return _focused_game_pk; }
+
+  // A surface over the frame's pixels in the mapping, not a copy, so it
+  // must be freed before this is destroyed.
+  SDL_Surface * frame() const;
+
+  size_t box_count() const { return _box_count; }
+  int64_t box_game_pk(size_t i) const;
+  // A copy of the box's pixels, which may outlive this.
+  SDL_Surface * box(size_t i) const;
+};
+
+#endif
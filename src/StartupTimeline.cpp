@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "StartupTimeline.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+namespace {
+
+struct Span {
+  std::string name;
+  double begin_ms;
+  double end_ms;
+  int thread;
+};
+
+// Set during static initialization, before main runs.
+const Clock::time_point process_start = Clock::now();
+
+bool enabled = false;
+std::mutex spans_mutex;
+std::vector<Span> spans;
+std::map<std::thread::id, int> thread_numbers;  // in order of first span
+
+}
+
+void enable_startup_timeline() {
+  enabled = true;
+}
+
+double startup_ms() {
+  return std::chrono::duration<double, std::milli>(Clock::now() - process_start).count();
+}
+
+StartupSpan::StartupSpan(const char * name)
+  : _name(name), _begin_ms(startup_ms()), _ended(false) {
+}
+
+void StartupSpan::end() {
+  if (_ended || !enabled) {
+    _ended = true;
+    return;
+  }
+  _ended = true;
+  double end_ms = startup_ms();
+  std::lock_guard<std::mutex> lock(spans_mutex);
+  auto inserted = thread_numbers.insert(std::make_pair(std::this_thread::get_id(),
+                                                       (int)thread_numbers.size()));
+  spans.push_back(Span{_name, _begin_ms, end_ms, inserted.first->second});
+}
+
+void print_startup_timeline(std::ostream & out) {
+  std::lock_guard<std::mutex> lock(spans_mutex);
+  if (spans.empty()) {
+    return;
+  }
+  std::vector<Span> sorted = spans;
+  std::stable_sort(sorted.begin(), sorted.end(), [](const Span & a, const Span & b) {
+      return a.begin_ms < b.begin_ms;
+    });
+  double last_ms = 0;
+  for (const Span & span : sorted) {
+    last_ms = std::max(last_ms, span.end_ms);
+  }
+
+  const int bar_width = 50;
+  char line[256];
+  out << "startup timeline, ms since process start:" << std::endl;
+  snprintf(line, sizeof(line), "  %8s %8s %8s %6s  %-24s", "begin", "end", "ms", "thread", "span");
+  out << line << std::endl;
+  for (const Span & span : sorted) {
+    std::string bar(bar_width, ' ');
+    int from = (int)(span.begin_ms / last_ms * (bar_width - 1));
+    int to = std::max(from, (int)(span.end_ms / last_ms * (bar_width - 1)));
+    std::fill(bar.begin() + from, bar.begin() + to + 1, '#');
+    snprintf(line, sizeof(line), "  %8.1f %8.1f %8.1f %6d  %-24s |%s|",
+             span.begin_ms, span.end_ms, span.end_ms - span.begin_ms,
+             span.thread, span.name.c_str(), bar.c_str());
+    out << line << std::endl;
+  }
+
+  // what loading cost the process so far, for comparing startup strategies
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+    long max_resident_kb = usage.ru_maxrss / 1024;  // bytes on macOS
+#else
+    long max_resident_kb = usage.ru_maxrss;
+#endif
+    snprintf(line, sizeof(line), "  max resident %ld kB, %ld blocks read, %ld page faults needing I/O",
+             max_resident_kb, (long)usage.ru_inblock, (long)usage.ru_majflt);
+    out << line << std::endl;
+  }
+}
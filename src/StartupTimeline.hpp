@@ -0,0 +1,33 @@
+#ifndef STARTUP_TIMELINE_HPP
+#define STARTUP_TIMELINE_HPP
+
+#include <iostream>
+
+#include "util.hpp"
+
+// Record of the spans of work done while starting up, on whichever thread
+// did them, for seeing where the time to the first frame goes. Recording is
+// off unless enabled; times are milliseconds since the process started.
+
+void enable_startup_timeline();
+double startup_ms();
+
+// Times the enclosing scope, or until end is called.
+class StartupSpan : Uncopyable {
+private:
+  const char * _name;
+  double _begin_ms;
+  bool _ended;
+
+public:
+  explicit StartupSpan(const char * name);
+  ~StartupSpan() { end(); }
+  void end();
+};
+
+// Prints the spans recorded so far, in order of their start, with a bar
+// per span so overlapping work lines up, then the process's peak resident
+// memory and disk reads so far.
+void print_startup_timeline(std::ostream & out);
+
+#endif
@@ -0,0 +1,51 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(int n_threads) : _running(0), _stopping(false) {
+  for (int i = 0; i < n_threads; i++) {
+    _workers.push_back(std::thread(&ThreadPool::work, this));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _task_available.notify_all();
+  for (std::thread & t : _workers) {
+    t.join();
+  }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _tasks.push_back(task);
+  }
+  _task_available.notify_one();
+}
+
+void ThreadPool::wait() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _idle.wait(lock, [this] { return _tasks.empty() && _running == 0; });
+}
+
+void ThreadPool::work() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true) {
+    _task_available.wait(lock, [this] { return _stopping || !_tasks.empty(); });
+    if (_tasks.empty()) {
+      return;  // stopping, and nothing left to do
+    }
+    std::function<void()> task = _tasks.front();
+    _tasks.pop_front();
+    _running++;
+    lock.unlock();
+    task();
+    lock.lock();
+    _running--;
+    if (_tasks.empty() && _running == 0) {
+      _idle.notify_all();
+    }
+  }
+}
@@ -0,0 +1,37 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "util.hpp"
+
+// Fixed set of worker threads running queued tasks in FIFO order.
+class ThreadPool : Uncopyable {
+private:
+  std::vector<std::thread> _workers;
+  std::deque<std::function<void()>> _tasks;
+  std::mutex _mutex;
+  std::condition_variable _task_available;
+  std::condition_variable _idle;
+  int _running;  // tasks taken off the queue and not yet finished
+  bool _stopping;
+
+  void work();
+
+public:
+  explicit ThreadPool(int n_threads);
+  // Finishes queued tasks before returning.
+  ~ThreadPool();
+
+  void submit(std::function<void()> task);
+
+  // Blocks until the queue is empty and no task is running.
+  void wait();
+};
+
+#endif
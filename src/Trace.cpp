@@ -0,0 +1,151 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Trace.hpp"
+
+#ifdef PHOTOLIST_TRACE
+
+typedef std::chrono::steady_clock Clock;
+
+namespace {
+
+struct Event {
+  const char * name;
+  double begin_us;  // since the process started
+  double end_us;
+  int thread;
+};
+
+// One thread's latest events. The lock is only contended while
+// write_trace copies them out.
+struct Ring {
+  static const size_t capacity = 1 << 15;
+  std::mutex mutex;
+  std::vector<Event> events;
+  uint64_t written;
+
+  Ring() : events(capacity), written(0) {
+  }
+
+  void push(const Event & event) {
+    std::lock_guard<std::mutex> lock(mutex);
+    events[written++ % capacity] = event;
+  }
+};
+
+// Set during static initialization, before main runs.
+const Clock::time_point process_start = Clock::now();
+
+std::mutex rings_mutex;
+std::vector<std::unique_ptr<Ring>> rings;  // every ring, in use or not
+std::vector<Ring *> free_rings;            // left by threads that exited
+std::map<int, std::string> thread_names;
+int next_thread = 1;
+
+// A thread's number and ring, taken at its first span. The ring is handed
+// on when the thread exits, so the many short-lived threads of a session
+// need no more rings than ever ran at once; events keep their own thread.
+struct ThreadTrace {
+  Ring * ring;
+  int thread;
+
+  ThreadTrace() {
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    thread = next_thread++;
+    if (free_rings.empty()) {
+      rings.emplace_back(new Ring);
+      ring = rings.back().get();
+    } else {
+      ring = free_rings.back();
+      free_rings.pop_back();
+    }
+  }
+
+  ~ThreadTrace() {
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    free_rings.push_back(ring);
+  }
+};
+
+ThreadTrace & this_thread_trace() {
+  thread_local ThreadTrace trace;
+  return trace;
+}
+
+double now_us() {
+  return std::chrono::duration<double, std::micro>(Clock::now() - process_start).count();
+}
+
+}
+
+TraceSpan::TraceSpan(const char * name) : _name(name), _begin_us(now_us()) {
+}
+
+TraceSpan::~TraceSpan() {
+  ThreadTrace & trace = this_thread_trace();
+  trace.ring->push(Event{_name, _begin_us, now_us(), trace.thread});
+}
+
+void name_trace_thread(const char * name) {
+  int thread = this_thread_trace().thread;
+  std::lock_guard<std::mutex> lock(rings_mutex);
+  thread_names[thread] = name;
+}
+
+bool tracing_compiled() {
+  return true;
+}
+
+bool write_trace(const std::string & filename) {
+  std::vector<Event> events;
+  std::map<int, std::string> names;
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    for (auto & ring : rings) {
+      std::lock_guard<std::mutex> ring_lock(ring->mutex);
+      uint64_t first = ring->written > Ring::capacity ? ring->written - Ring::capacity : 0;
+      for (uint64_t i = first; i < ring->written; i++) {
+        events.push_back(ring->events[i % Ring::capacity]);
+      }
+    }
+    names = thread_names;
+  }
+
+  FILE * out = fopen(filename.c_str(), "w");
+  if (out == nullptr) {
+    return false;
+  }
+  fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  const char * separator = "";
+  for (auto & name : names) {
+    fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            separator, name.first, name.second.c_str());
+    separator = ",\n";
+  }
+  for (const Event & event : events) {
+    fprintf(out, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+            separator, event.name, event.thread, event.begin_us, event.end_us - event.begin_us);
+    separator = ",\n";
+  }
+  fprintf(out, "\n]}\n");
+  bool failed = ferror(out) != 0;
+  return fclose(out) == 0 && !failed;
+}
+
+#else
+
+bool tracing_compiled() {
+  return false;
+}
+
+bool write_trace(const std::string & filename) {
+  (void)filename;
+  return false;
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <string>
+
+#include "util.hpp"
+
+// Spans of work on every thread, for reading a whole session on a
+// timeline: TRACE_SPAN("name") times the rest of the enclosing scope.
+// Each thread records into its own ring buffer, so recording takes no
+// shared lock and a long session keeps its latest events. Spans compile
+// to nothing unless PHOTOLIST_TRACE is defined, as by `make
+// PhotoList-trace`; names must be string literals.
+//
+// write_trace saves what the buffers hold in Chrome's trace event format,
+// for chrome://tracing or Perfetto.
+
+#ifdef PHOTOLIST_TRACE
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) name_trace_thread(name)
+
+class TraceSpan : Uncopyable {
+private:
+  const char * _name;
+  double _begin_us;
+
+public:
+  explicit TraceSpan(const char * name);
+  ~TraceSpan();
+};
+
+void name_trace_thread(const char * name);
+
+#else
+
+#define TRACE_SPAN(name) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+
+#endif
+
+// Whether spans are compiled in.
+bool tracing_compiled();
+
+// Writes the spans recorded so far to filename; false if it couldn't.
+bool write_trace(const std::string & filename);
+
+#endif
@@ -0,0 +1,27 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "WakeupStats.hpp"
+
+WakeupStats::WakeupStats() : _report(false), _since(0) {
+  std::fill(_counts, _counts + n_causes, 0);
+}
+
+void WakeupStats::enable_report() {
+  _report = true;
+  _since = SDL_GetTicks();
+}
+
+void WakeupStats::count(Cause cause) {
+  _counts[cause]++;
+  Uint32 now = SDL_GetTicks();
+  if (_report && now - _since >= wakeup_report_seconds * 1000) {
+    double seconds = (now - _since) / 1000.0;
+    fprintf(stderr, "wakeups/s: %.2f (input %.2f, background %.2f, timer %.2f, poll %.2f)\n",
+            (_counts[input] + _counts[background] + _counts[timer] + _counts[poll]) / seconds,
+            _counts[input] / seconds, _counts[background] / seconds,
+            _counts[timer] / seconds, _counts[poll] / seconds);
+    std::fill(_counts, _counts + n_causes, 0);
+    _since = now;
+  }
+}
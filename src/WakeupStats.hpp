@@ -0,0 +1,30 @@
+#ifndef WAKEUP_STATS_HPP
+#define WAKEUP_STATS_HPP
+
+#include "SDL.h"
+
+// Why the main loop woke up, for seeing how often an idle kiosk wakes. With
+// reporting on, rates are printed every wakeup_report_seconds.
+class WakeupStats {
+public:
+  enum Cause {
+    input,
+    background,
+    timer,
+    poll,  // checked for input and found none
+    n_causes
+  };
+
+  WakeupStats();
+
+  void enable_report();
+  void count(Cause cause);
+
+private:
+  static const Uint32 wakeup_report_seconds = 10;
+  bool _report;
+  Uint32 _since;
+  unsigned _counts[n_causes];
+};
+
+#endif
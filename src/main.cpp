@@ -6,22 +6,63 @@
 //  Copyright © 2020 John Garvin. All rights reserved.
 //
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <iostream>
 #include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <future>
 #include <list>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "SDL.h"
 #include "SDL_image.h"
 #include "SDL_ttf.h"
 
+#include "Catalog.hpp"
+#include "CatalogCache.hpp"
+#include "Date.hpp"
+#include "DeltaStream.hpp"
 #include "Download.hpp"
-#include "PhotoData.hpp"
+#include "FacetIndex.hpp"
+#include "FeedSet.hpp"
+#include "FrameClock.hpp"
+#include "FrameScheduler.hpp"
+#include "InputLatency.hpp"
+#include "JsonFilter.hpp"
+#include "PhotoSizes.hpp"
+#include "Resource.hpp"
+#include "SearchIndex.hpp"
+#include "ScheduleRefresher.hpp"
+#include "ScriptedRun.hpp"
+#include "SeasonIndex.hpp"
+#include "SessionSnapshot.hpp"
+#include "StartupTimeline.hpp"
+#include "Trace.hpp"
+#include "WakeupStats.hpp"
 #include "util.hpp"
 
-const std::string json_url = "http://statsapi.mlb.com/api/v1/schedule?hydrate=game(content(editorial(recap))),decisions&date=2018-06-10&sportId=1";
+// statsapi, or a stand-in for it such as tools/statsapi_standin.py
+std::string statsapi_origin = "http://statsapi.mlb.com";
+const char * schedule_path_format = "/api/v1/schedule?hydrate=game(content(editorial(recap))),decisions&date=%s&sportId=%d";
+// MLB; other leagues can be shown alongside with --sports
+const int default_sport_id = 1;
+const std::string initial_date = "2018-06-10";
 const std::string background_filename = "images/1.jpg";
 const std::string dots_filename = "images/dots.jpg";
 
@@ -29,24 +70,128 @@ const char * font_filename = "fonts/LiberationSans-Regular.ttf";
 const int headline_font_size = 48;
 const int subhead_font_size = 24;
 
-// Choose the smallest photos at least this width in pixels
-const int minimum_width = 400;
+// Fetch the schedule for the next or previous date once the focus is this
+// many games from either end of the catalog
+const size_t page_ahead_games = 5;
+// Keep at most this many dates of games in memory
+const size_t max_loaded_dates = 7;
+// Seconds before paging again toward a date whose every feed failed
+const int page_retry_seconds = 30;
+// Concurrent transfers when building a season index
+const int season_index_threads = 16;
+// Seconds between conditional polls of the shown dates' feeds
+const int refresh_interval_seconds = 60;
+// Carousel transitions ease over this long, drawn a frame every frame_ms
+const double transition_ms = 250;
+const double frame_ms = 1000.0 / 60;
+// Without a blocking wait for input (see wait_for_event), poll for it this
+// often for a while after input, and less often when idle
+const int active_poll_ms = 16;
+const int idle_poll_ms = 50;
+const Uint32 active_seconds = 2;
+// What is on screen is saved here on exit and at this interval, for the
+// next launch to restore
+const std::string session_filename = "cache/session.bin";
+const int session_save_seconds = 30;
+// A scripted run checks for its next step at least this often, and gives
+// up waiting for the app to settle after settle_timeout_ms
+const int script_poll_ms = 10;
+const Uint32 settle_timeout_ms = 10000;
 
-// Set aspect ratio here
-static const char * aspect_ratio_string = "16:9";
-static int box_height_for_width(int width) {
-  return width * 9 / 16;
+static std::string sport_schedule_url(int sport_id, const std::string & date) {
+  char path[512];
+  snprintf(path, sizeof(path), schedule_path_format, date.c_str(), sport_id);
+  return statsapi_origin + path;
 }
 
-// Set scale factor of focused box here
-static int scale_fbox(int x) {
-  return x * 3 / 2;
+static std::string schedule_url(const std::string & date) {
+  return sport_schedule_url(default_sport_id, date);
+}
+
+static std::vector<FeedSet::UrlForDate> sport_feeds(const std::vector<int> & sport_ids) {
+  std::vector<FeedSet::UrlForDate> feeds;
+  for (int sport_id : sport_ids) {
+    feeds.push_back([sport_id](const std::string & date) {
+        return sport_schedule_url(sport_id, date);
+      });
+  }
+  return feeds;
+}
+
+// Both sizes are opened from one mapping of the font file, which must stay
+// open as long as they do.
+struct Fonts {
+  std::unique_ptr<Resource> file;
+  TTF_Font * headline;
+  TTF_Font * subhead;
+};
+
+static Fonts open_fonts() {
+  StartupSpan span("fonts");
+  if (TTF_Init() != 0) {
+    error("Couldn't initialize TTF");
+  }
+  Fonts fonts;
+  fonts.file.reset(new Resource(font_filename));
+  fonts.headline = fonts.file->open_font(headline_font_size);
+  fonts.subhead = fonts.file->open_font(subhead_font_size);
+  return fonts;
+}
+
+static SDL_Surface * load_image(std::string filename) {
+  StartupSpan span(filename == background_filename ? "background" : "dots");
+  return Resource(filename).load_image();
+}
+
+template <typename T>
+static bool is_ready(const std::future<T> & f) {
+  return f.valid() && f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+// Event type posted by background work that has something for the main
+// loop, which otherwise sleeps until input or a timer is due. Registered once
+// SDL is up; posts before then are dropped, and whatever they were for is
+// picked up when the loop first runs.
+static std::atomic<Uint32> wake_event_type((Uint32)-1);
+// Ends a polling sleep in wait_for_event early
+static std::mutex wake_mutex;
+static std::condition_variable wake_signal;
+static bool woken = false;
+
+static void wake_main_loop() {
+  Uint32 type = wake_event_type;
+  if (type != (Uint32)-1) {
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = type;
+    SDL_PushEvent(&event);
+  }
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex);
+    woken = true;
+  }
+  wake_signal.notify_one();
+}
+
+// Like std::async, but wakes the main loop once the result is ready, not
+// just computed. task finishes with f and must be kept until it has.
+template <typename T>
+static std::future<T> start_and_wake(std::function<T()> f, std::future<void> & task) {
+  std::shared_ptr<std::promise<T>> promise = std::make_shared<std::promise<T>>();
+  std::future<T> result = promise->get_future();
+  task = std::async(std::launch::async, [f, promise] {
+      promise->set_value(f());
+      wake_main_loop();
+    });
+  return result;
 }
 
 class PLView : Uncopyable {
 private:
   SDL_Window * _window;
   SDL_Surface * _wsurface;
+  int _offscreen_w;  // draw into a surface this size instead, if not 0
+  int _offscreen_h;
 
   // height and width of the screen
   int _height;
@@ -57,7 +202,7 @@ private:
   std::list<SDL_Surface *> _boxes;
   std::list<SDL_Surface *>::iterator _fbox;  // box that is focused
   
-  const int _box_w = 300;      // size of non-focused box
+  const int _box_w = box_width;  // size of non-focused box
   const int _box_h = box_height_for_width(_box_w);
   const int _box_spacing = 100;  // distance between boxes
   int _box_middle_y;             // y coordinate of middle of non-focused boxes
@@ -67,30 +212,345 @@ private:
   int _fbox_w;
   int _fbox_h;
 
-  void render_background() {
-    int result = SDL_BlitScaled(_background, NULL, _wsurface, NULL);
-    if (result != 0) {
-      error("render_background: couldn't blit background");
+  // What a frame draws, in order, each surface scaled to its rect. The
+  // surfaces are held by reference count, so the frame can be composed
+  // after the caller has let go of them; counts are only changed on the
+  // main thread.
+  struct Frame {
+    std::vector<std::pair<SDL_Surface *, SDL_Rect>> placed;
+    Uint64 requested;  // performance counter at render_all
+    double compose_ms;
+    bool loading;  // some box still shows the dots
+  };
+
+  // Frames are composed on _composer into one of two back buffers, while
+  // the main thread presents the one composed before it. A frame rendered
+  // while another is composing waits, replaced by any newer one.
+  bool _pipelined;
+  std::thread _composer;
+  std::mutex _compose_mutex;
+  std::condition_variable _compose_wanted;
+  std::condition_variable _compose_done;
+  enum ComposeState {
+    compose_idle,
+    composing,
+    composed
+  };
+  ComposeState _compose_state;  // guarded by _compose_mutex
+  bool _stopping;               // guarded by _compose_mutex
+  Frame * _composing_source;    // the composer's while composing
+  SDL_Surface * _composing_target;
+  int _composing_speculation;   // index into _speculations, or -1
+  Frame _composing_frame;
+  SDL_Surface * _back_buffers[2];
+  int _next_buffer;
+  bool _real_in_flight;  // a rendered frame is composing or composed
+  bool _has_waiting_frame;
+  Frame _waiting_frame;
+
+  // Frames composed while idle for the states a key press can lead to. A
+  // rendered frame placing exactly the same surfaces in the same rects as
+  // a composed one is presented from its buffer without composing. Frames
+  // hold their surfaces, so a surface that was replaced, such as the dots
+  // once a photo is in, can't match a new one at the same address.
+  struct Speculation {
+    Frame frame;
+    bool composed;
+  };
+  std::vector<Speculation> _speculations;  // changed only while not composing
+  SDL_Surface * _speculation_buffers[2];
+
+public:
+  // Frames drawn since the last take_render_stats, for comparing the
+  // pipelined and single-stage paths.
+  struct RenderStats {
+    unsigned presented;
+    unsigned superseded;  // replaced by a newer frame before composing
+    unsigned precomposed;  // presented from a speculation
+    double latency_ms_total;  // render_all to presented
+    double latency_ms_max;
+    double compose_ms_total;
+    double present_ms_total;
+  };
+
+  // One presented frame, as it's presented.
+  struct PresentTiming {
+    unsigned frame;  // counting from the window opening
+    double compose_ms;
+    double present_ms;
+    double latency_ms;
+    bool precomposed;
+    bool loading;
+    Uint64 requested;  // performance counters at render_all and once presented
+    Uint64 presented;
+  };
+
+  // What the wrapper shows: the boxes either side of the focused box, in
+  // order outward, and the text. During a transition every box is drawn
+  // offset slots from its own, along with boxes departing the carousel.
+  struct Layout {
+    std::list<SDL_Surface *> left_boxes;
+    std::list<SDL_Surface *> right_boxes;
+    SDL_Surface * fbox;  // null when there is nothing to show
+    SDL_Surface * headline;
+    SDL_Surface * subhead;
+    SDL_Surface * status;  // drawn at the top of the screen
+    double offset;
+    std::vector<std::pair<SDL_Surface *, int>> departing;  // by slot
+    bool loading;  // some box still shows the dots
+  };
+
+private:
+  RenderStats _stats;
+  unsigned _frames_presented;
+  std::function<void(const PresentTiming &)> _on_present;
+
+  static double ms_since(Uint64 since) {
+    return (SDL_GetPerformanceCounter() - since) * 1000.0 / SDL_GetPerformanceFrequency();
+  }
+
+  void place(Frame & frame, SDL_Surface * surface, int x, int y, int w, int h) {
+    SDL_Rect rect;
+    rect.x = x;
+    rect.y = y;
+    rect.w = w;
+    rect.h = h;
+    surface->refcount++;
+    frame.placed.push_back(std::make_pair(surface, rect));
+  }
+
+  void place_in_slot(Frame & frame, SDL_Surface * box, double slot) {
+    SDL_Rect r = slot_rect(slot);
+    place(frame, box, r.x, r.y, r.w, r.h);
+  }
+
+  void release(Frame & frame) {
+    for (auto & p : frame.placed) {
+      SDL_FreeSurface(p.first);
     }
-    SDL_UpdateWindowSurface(_window);
+    frame.placed.clear();
   }
-  
-  void render_surface(SDL_Surface * box, int x, int y, int w, int h) {
-    SDL_Rect dstrect;
-    dstrect.x = x;
-    dstrect.y = y;
-    dstrect.w = w;
-    dstrect.h = h;
-    int result = SDL_BlitScaled(box, NULL, _wsurface, &dstrect);
-    if (result != 0) {
-      error("render_surface: couldn't blit surface");
+
+  static bool same_placement(const Frame & a, const Frame & b) {
+    if (a.placed.size() != b.placed.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < a.placed.size(); i++) {
+      const SDL_Rect & ra = a.placed[i].second;
+      const SDL_Rect & rb = b.placed[i].second;
+      if (a.placed[i].first != b.placed[i].first
+          || ra.x != rb.x || ra.y != rb.y || ra.w != rb.w || ra.h != rb.h) {
+        return false;
+      }
     }
+    return true;
   }
 
-public:
-  const int n_displayed_each_side = 3;  // # boxes left or right of fbox
+  static void compose(Frame & frame, SDL_Surface * target) {
+    TRACE_SPAN("compose");
+    Uint64 begin = SDL_GetPerformanceCounter();
+    for (auto & p : frame.placed) {
+      SDL_Rect rect = p.second;  // clipped by the blit
+      if (SDL_BlitScaled(p.first, NULL, target, &rect) != 0) {
+        error("compose: couldn't blit surface");
+      }
+    }
+    frame.compose_ms = ms_since(begin);
+  }
+
+  void compose_frames() {
+    TRACE_THREAD_NAME("composer");
+    std::unique_lock<std::mutex> lock(_compose_mutex);
+    for (;;) {
+      _compose_wanted.wait(lock, [this] { return _stopping || _compose_state == composing; });
+      if (_stopping) {
+        return;
+      }
+      lock.unlock();
+      compose(*_composing_source, _composing_target);
+      lock.lock();
+      _compose_state = composed;
+      _compose_done.notify_all();
+      lock.unlock();
+      wake_main_loop();
+      lock.lock();
+    }
+  }
+
+  // Starts the composer on the waiting frame, or else on a speculation.
+  void start_composing() {
+    {
+      std::lock_guard<std::mutex> lock(_compose_mutex);
+      if (_compose_state != compose_idle) {
+        return;
+      }
+      if (_has_waiting_frame) {
+        _composing_frame = std::move(_waiting_frame);
+        _waiting_frame.placed.clear();
+        _has_waiting_frame = false;
+        _composing_source = &_composing_frame;
+        _composing_target = _back_buffers[_next_buffer];
+        _next_buffer = 1 - _next_buffer;
+        _composing_speculation = -1;
+        _real_in_flight = true;
+      } else {
+        size_t i = 0;
+        while (i < _speculations.size() && _speculations[i].composed) {
+          i++;
+        }
+        if (i == _speculations.size()) {
+          return;
+        }
+        _composing_source = &_speculations[i].frame;
+        _composing_target = _speculation_buffers[i];
+        _composing_speculation = i;
+      }
+      _compose_state = composing;
+    }
+    _compose_wanted.notify_one();
+  }
+
+  void present(Frame & frame, SDL_Surface * composed_buffer) {
+    TRACE_SPAN("present");
+    Uint64 begin = SDL_GetPerformanceCounter();
+    if (composed_buffer != nullptr && SDL_BlitSurface(composed_buffer, NULL, _wsurface, NULL) != 0) {
+      error("present: couldn't copy frame");
+    }
+    if (_window != nullptr) {
+      SDL_UpdateWindowSurface(_window);
+    }
+    Uint64 presented = SDL_GetPerformanceCounter();
+    double latency_ms = ms_since(frame.requested);
+    _stats.presented++;
+    _frames_presented++;
+    _stats.latency_ms_total += latency_ms;
+    _stats.latency_ms_max = std::max(_stats.latency_ms_max, latency_ms);
+    _stats.compose_ms_total += frame.compose_ms;
+    double present_ms = ms_since(begin);
+    _stats.present_ms_total += present_ms;
+    if (_on_present) {
+      bool precomposed = composed_buffer != nullptr
+        && (composed_buffer == _speculation_buffers[0] || composed_buffer == _speculation_buffers[1]);
+      _on_present(PresentTiming{_frames_presented, frame.compose_ms, present_ms, latency_ms,
+                                precomposed, frame.loading, frame.requested, presented});
+    }
+    release(frame);
+  }
+
+  void submit(Frame & frame) {
+    if (!_pipelined) {
+      compose(frame, _wsurface);
+      present(frame, nullptr);
+      return;
+    }
+    // out of order if an earlier frame is still to be presented
+    if (!_real_in_flight && !_has_waiting_frame) {
+      for (auto & speculation : _speculations) {
+        if (speculation.composed && same_placement(speculation.frame, frame)) {
+          _stats.precomposed++;
+          present(frame, _speculation_buffers[&speculation - &_speculations[0]]);
+          return;
+        }
+      }
+    }
+    if (_has_waiting_frame) {
+      release(_waiting_frame);
+      _stats.superseded++;
+    }
+    _waiting_frame = std::move(frame);
+    _has_waiting_frame = true;
+    start_composing();
+  }
+
+  Frame build_frame(const Layout & layout) {
+    Frame frame;
+    frame.requested = SDL_GetPerformanceCounter();
+    frame.compose_ms = 0;
+    frame.loading = layout.loading;
+    if (_background != nullptr) {
+      place(frame, _background, 0, 0, _wsurface->w, _wsurface->h);
+    }
+
+    // render status
+    if (layout.status != nullptr) {
+      place(frame, layout.status,
+            _width / 2 - layout.status->w / 2,
+            _box_spacing / 2,
+            layout.status->w,
+            layout.status->h);
+    }
+
+    // render headline
+    if (layout.headline != nullptr) {
+      place(frame, layout.headline,
+            _width / 2 - layout.headline->w / 2,
+            _box_middle_y - _fbox_h / 2 - _box_spacing,
+            layout.headline->w,
+            layout.headline->h);
+    }
+
+    // render subhead
+    if (layout.subhead != nullptr) {
+      place(frame, layout.subhead,
+            _width / 2 - layout.subhead->w / 2,
+            _box_middle_y + _fbox_h / 2 + _box_spacing,
+            layout.subhead->w,
+            layout.subhead->h);
+    }
+    
+    // render side boxes, then fbox over any it overlaps mid-transition
+    for (auto & d : layout.departing) {
+      place_in_slot(frame, d.first, d.second + layout.offset);
+    }
+    int slot = -1;
+    for (auto b : layout.left_boxes) {
+      place_in_slot(frame, b, slot-- + layout.offset);
+    }
+    slot = 1;
+    for (auto b : layout.right_boxes) {
+      place_in_slot(frame, b, slot++ + layout.offset);
+    }
+    if (layout.fbox != nullptr) {
+      place_in_slot(frame, layout.fbox, layout.offset);
+    }
+    return frame;
+  }
+
+  // Where a box is drawn, by slot: 0 is the focused box and negative slots
+  // are to its left. Slots in between, passed through during a transition,
+  // are in between in both position and size.
+  SDL_Rect slot_rect(double slot) const {
+    int lower = (int)std::floor(slot);
+    double t = slot - lower;
+    SDL_Rect a = whole_slot_rect(lower);
+    SDL_Rect b = whole_slot_rect(lower + 1);
+    SDL_Rect r;
+    r.x = (int)std::lround(a.x + (b.x - a.x) * t);
+    r.y = (int)std::lround(a.y + (b.y - a.y) * t);
+    r.w = (int)std::lround(a.w + (b.w - a.w) * t);
+    r.h = (int)std::lround(a.h + (b.h - a.h) * t);
+    return r;
+  }
 
-  PLView() {
+  SDL_Rect whole_slot_rect(int slot) const {
+    SDL_Rect r;
+    if (slot == 0) {
+      r.x = _fbox_x;
+      r.y = _fbox_y;
+      r.w = _fbox_w;
+      r.h = _fbox_h;
+      return r;
+    }
+    r.x = slot > 0
+      ? _fbox_x + _fbox_w + _box_spacing + (slot - 1) * (_box_w + _box_spacing)
+      : _fbox_x - _box_spacing - _box_w + (slot + 1) * (_box_w + _box_spacing);
+    r.y = _box_y;
+    r.w = _box_w;
+    r.h = _box_h;
+    return r;
+  }
+
+  void open_onscreen() {
     int result;
     
     result = SDL_Init(SDL_INIT_VIDEO);
@@ -121,15 +581,103 @@ public:
 
     _height = dm.h;
     _width = dm.w;
+  }
+
+  // Events and timers still work without the video subsystem, so the rest
+  // of the app can't tell the difference.
+  void open_offscreen() {
+    if (SDL_Init(SDL_INIT_EVENTS | SDL_INIT_TIMER) != 0) {
+      error("could not initialize SDL");
+    }
+    _wsurface = SDL_CreateRGBSurfaceWithFormat(0, _offscreen_w, _offscreen_h, 32,
+                                               SDL_PIXELFORMAT_RGB888);
+    if (_wsurface == nullptr) {
+      error("could not create off-screen surface");
+    }
+    _width = _offscreen_w;
+    _height = _offscreen_h;
+  }
+
+
+public:
+  const int n_displayed_each_side = 3;  // # boxes left or right of fbox
+
+  PLView() : _window(nullptr), _wsurface(nullptr), _offscreen_w(0), _offscreen_h(0),
+             _background(nullptr), _pipelined(true),
+             _compose_state(compose_idle), _stopping(false), _composing_source(nullptr),
+             _composing_target(nullptr), _composing_speculation(-1), _next_buffer(0),
+             _real_in_flight(false), _has_waiting_frame(false), _frames_presented(0) {
+    for (int i = 0; i < 2; i++) {
+      _back_buffers[i] = nullptr;
+      _speculation_buffers[i] = nullptr;
+    }
+    _stats = RenderStats();
+  }
+
+  // Compose and present each frame on the main thread, as before frames
+  // were pipelined. Set before the window opens.
+  void set_pipelined(bool pipelined) {
+    _pipelined = pipelined;
+  }
+
+  // Draw into an off-screen surface of this size instead of opening a
+  // window, so no display is needed. Set before the window opens.
+  void set_offscreen(int w, int h) {
+    _offscreen_w = w;
+    _offscreen_h = h;
+  }
+
+  // Must run on the main thread. Until then only the pixel widths below are
+  // unknown; images and fonts can be loaded without a window.
+  void open_window() {
+    if (_offscreen_w > 0) {
+      open_offscreen();
+    } else {
+      open_onscreen();
+    }
     _box_middle_y = _height * 2 / 5;
     _box_y = _box_middle_y - _box_h / 2;
     _fbox_x = _width / 2 - scale_fbox(_box_w) / 2;
     _fbox_y = _box_middle_y - scale_fbox(_box_h) / 2;
     _fbox_w = scale_fbox(_box_w);
     _fbox_h = scale_fbox(_box_h);
+
+    if (_pipelined) {
+      for (int i = 0; i < 4; i++) {
+        SDL_Surface *& buffer = i < 2 ? _back_buffers[i] : _speculation_buffers[i - 2];
+        buffer = SDL_CreateRGBSurfaceWithFormat(0, _wsurface->w, _wsurface->h,
+                                                _wsurface->format->BitsPerPixel,
+                                                _wsurface->format->format);
+        if (buffer == nullptr) {
+          error("could not create back buffer");
+        }
+      }
+      _composer = std::thread(&PLView::compose_frames, this);
+    }
   }
 
   ~PLView() {
+    if (_composer.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(_compose_mutex);
+        _stopping = true;
+      }
+      _compose_wanted.notify_one();
+      _composer.join();
+    }
+    release(_composing_frame);
+    release(_waiting_frame);
+    for (auto & speculation : _speculations) {
+      release(speculation.frame);
+    }
+    for (int i = 0; i < 2; i++) {
+      if (_back_buffers[i] != nullptr) {
+        SDL_FreeSurface(_back_buffers[i]);
+      }
+      if (_speculation_buffers[i] != nullptr) {
+        SDL_FreeSurface(_speculation_buffers[i]);
+      }
+    }
     while (!_boxes.empty()) {
       SDL_Surface * s = _boxes.back();
       SDL_FreeSurface(s);
@@ -138,211 +686,1631 @@ public:
     if (_background != nullptr) {
       SDL_FreeSurface(_background);
     }
-    SDL_FreeSurface(_wsurface);
-    SDL_DestroyWindow(_window);
-    SDL_Quit();
+    if (_wsurface != nullptr) {
+      SDL_FreeSurface(_wsurface);
+      if (_window != nullptr) {
+        SDL_DestroyWindow(_window);
+      }
+      SDL_Quit();
+    }
   }
   
+  // Widths in pixels at which the boxes are actually drawn. Photos at least
+  // this wide don't need to be scaled up. The window surface has one pixel
+  // per screen coordinate even on a HiDPI display (SDL 2.0.10 doesn't scale
+  // it), so these are just the boxes' widths.
+  int box_pixel_width() const { return _box_w; }
+  int fbox_pixel_width() const { return _fbox_w; }
+  // Distance between side boxes, which a transition moves them by.
+  int slot_pitch() const { return _box_w + _box_spacing; }
+  // Width of the focused box as fitted by fit_to_box.
+  int fbox_width() const { return _fbox_w; }
+
+  // Takes the background, keeping it fitted to the window so each frame
+  // copies it rather than scaling it.
   void set_background(SDL_Surface * background) {
-    _background = background;
-    render_background();
+    _background = fit(background, _wsurface->w, _wsurface->h);
   }
 
-  void render_all(const std::list<SDL_Surface *> & left_boxes,
-                  const std::list<SDL_Surface *> & right_boxes,
-                  SDL_Surface * fbox,
-                  SDL_Surface * headline,
-                  SDL_Surface * subhead) {
-    render_background();
+  void show_background() {
+    show_still(_background);
+  }
 
-    // render headline
-    if (headline != nullptr) {
-      render_surface(headline,
-                    _width / 2 - headline->w / 2,
-                    _box_middle_y - _fbox_h / 2 - _box_spacing,
-                    headline->w,
-                    headline->h);
+  // Returns image, which is freed, in the window's pixel format at the size
+  // a side box or the focused box is drawn. Drawing it there is then a plain
+  // copy, and in between sizes SDL's same-format stretch. Safe off the main
+  // thread once the window is open. An image that failed to load, null,
+  // stays null.
+  SDL_Surface * fit_to_box(SDL_Surface * image, bool focused) const {
+    if (image == nullptr) {
+      return nullptr;
+    }
+    return focused ? fit(image, _fbox_w, _fbox_h) : fit(image, _box_w, _box_h);
+  }
+
+  SDL_Surface * fit(SDL_Surface * image, int w, int h) const {
+    TRACE_SPAN("fit");
+    SDL_Surface * converted = SDL_ConvertSurface(image, _wsurface->format, 0);
+    SDL_Surface * fitted = SDL_CreateRGBSurfaceWithFormat(0, w, h,
+                                                          _wsurface->format->BitsPerPixel,
+                                                          _wsurface->format->format);
+    if (converted == nullptr || fitted == nullptr
+        || SDL_SoftStretch(converted, NULL, fitted, NULL) != 0) {
+      error("couldn't fit image to its box");
     }
+    SDL_FreeSurface(converted);
+    SDL_FreeSurface(image);
+    return fitted;
+  }
 
-    // render subhead
-    if (subhead != nullptr) {
-      render_surface(subhead,
-                    _width / 2 - subhead->w / 2,
-                    _box_middle_y + _fbox_h / 2 + _box_spacing,
-                    subhead->w,
-                    subhead->h);
+  // Fill the window with one image, such as the background or a saved
+  // frame, until the next render_all.
+  void show_still(SDL_Surface * image) {
+    flush();
+    int result = SDL_BlitScaled(image, NULL, _wsurface, NULL);
+    if (result != 0) {
+      error("show_still: couldn't blit image");
     }
-    
-    // render fbox
-    render_surface(fbox, _fbox_x, _fbox_y, _fbox_w, _fbox_h);
+    if (_window != nullptr) {
+      SDL_UpdateWindowSurface(_window);
+    }
+  }
 
-    // render left boxes
-    int x = _fbox_x - _box_spacing - _box_w;
-    for (auto b : left_boxes) {
-      render_surface(b, x, _box_y, _box_w, _box_h);
-      x -= _box_w + _box_spacing;
+  // The window's pixels as last drawn, once every frame rendered so far
+  // has been presented.
+  SDL_Surface * frame() {
+    flush();
+    return _wsurface;
+  }
+
+  // Presents the frame the composer last finished, if it has, having first
+  // started it on the next. With wait, waits for a frame being composed.
+  // Returns whether a frame was presented.
+  bool present_composed(bool wait = false) {
+    for (;;) {
+      int speculation;
+      SDL_Surface * buffer;
+      {
+        std::unique_lock<std::mutex> lock(_compose_mutex);
+        if (wait) {
+          _compose_done.wait(lock, [this] { return _compose_state != composing; });
+        }
+        if (_compose_state != composed) {
+          return false;
+        }
+        speculation = _composing_speculation;
+        buffer = _composing_target;
+        _compose_state = compose_idle;
+      }
+      if (speculation >= 0) {
+        _speculations[speculation].composed = true;
+        start_composing();
+        continue;
+      }
+      Frame done = std::move(_composing_frame);
+      _composing_frame.placed.clear();
+      _real_in_flight = false;
+      start_composing();
+      present(done, buffer);
+      return true;
     }
-    
-    // render right boxes
-    x = _fbox_x + _fbox_w + _box_spacing;
-    for (auto b : right_boxes) {
-      render_surface(b, x, _box_y, _box_w, _box_h);
-      x += _box_w + _box_spacing;
+  }
+
+  // Presents every frame rendered so far.
+  void flush() {
+    while (present_composed(true)) {
     }
+  }
+
+  // Called on the main thread with each frame presented.
+  void on_present(std::function<void(const PresentTiming &)> callback) {
+    _on_present = callback;
+  }
+
+  RenderStats take_render_stats() {
+    RenderStats stats = _stats;
+    _stats = RenderStats();
+    return stats;
+  }
+
+  void render_all(const Layout & layout) {
+    TRACE_SPAN("render_all");
+    Frame frame = build_frame(layout);
+    submit(frame);
+  }
 
-    SDL_UpdateWindowSurface(_window);
+  // Replaces the speculations with frames for these layouts, to be
+  // composed when the composer has nothing rendered to do. Layouts whose
+  // frames are unchanged keep their composition.
+  void speculate(const std::vector<Layout> & layouts) {
+    if (!_pipelined) {
+      return;
+    }
+    {
+      // the composer may be reading a speculation
+      std::unique_lock<std::mutex> lock(_compose_mutex);
+      _compose_done.wait(lock, [this] {
+          return _compose_state != composing || _composing_speculation < 0;
+        });
+      if (_compose_state == composed && _composing_speculation >= 0) {
+        _compose_state = compose_idle;
+      }
+    }
+    for (size_t i = 0; i < layouts.size() && i < 2; i++) {
+      Frame frame = build_frame(layouts[i]);
+      if (i < _speculations.size() && same_placement(_speculations[i].frame, frame)) {
+        release(frame);
+        continue;
+      }
+      if (i < _speculations.size()) {
+        release(_speculations[i].frame);
+      } else {
+        _speculations.push_back(Speculation());
+      }
+      _speculations[i].frame = std::move(frame);
+      _speculations[i].composed = false;
+    }
+    while (_speculations.size() > layouts.size()) {
+      release(_speculations.back().frame);
+      _speculations.pop_back();
+    }
+    start_composing();
   }
 };
 
 class PLViewWrapper : Uncopyable {
 private:
-  std::list<PhotoData> _games;
-  std::list<PhotoData>::iterator _fgame;  // box that is focused
-  std::list<PhotoData>::iterator _begin_displayed;
-  std::list<PhotoData>::iterator _end_displayed;
+  // Games of one schedule date, in catalog order.
+  struct DatePage {
+    std::string date;
+    size_t count;
+  };
+
+  // Result of loading a neighboring date in the background.
+  struct PageLoad {
+    Catalog games;
+    bool failed;  // every feed failed, so it isn't spliced in
+  };
+
+  Catalog _games;
+  std::deque<DatePage> _pages;  // dates in _games, in order
+  FeedSet _feeds;
+  ScheduleRefresher _refresher;
+  std::vector<std::string> _watched_dates;
+  // merged catalogs that arrived for a date still being paged in
+  std::map<std::string, Catalog> _early_updates;
+  std::unique_ptr<DeltaStream> _deltas;  // push mode, in place of periodic polls
+  std::string _next_date;
+  std::future<PageLoad> _next_page;  // games of the date after the last page
+  std::future<void> _next_page_task;
+  Uint32 _next_retry_ticks;  // when paging forward may start again
+  std::string _prev_date;
+  std::future<PageLoad> _prev_page;  // games of the date before the first page
+  std::future<void> _prev_page_task;
+  Uint32 _prev_retry_ticks;
+  bool _paging;  // off when browsing a fixed season
+
+  // The carousel shows either the whole catalog or, while filtered, the
+  // games in _matches: those matching both the query and the facet
+  // selection. Positions below are in that shown sequence; use game_at to
+  // get a catalog index.
+  SearchIndex _search;
+  bool _searching;  // taking text input for the query
+  std::string _query;
+  FacetIndex _facets;
+  FacetIndex::Selection _selection;
+  FacetIndex::Counts _facet_counts;
+  bool _filtered;
+  std::vector<uint32_t> _matches;
+
+  size_t _fgame;  // box that is focused
+  size_t _begin_displayed;
+  size_t _end_displayed;  // one past the rightmost displayed
+
+  // Surfaces of games that were displayed before the shown sequence
+  // changed, by catalog index, to be picked up by load_box_later
+  std::map<size_t, SDL_Surface *> _reusable;
+
+  // A box image downloading in the background, swapped in by
+  // apply_loaded_boxes if its game is still displayed
+  struct PendingBox {
+    int64_t game_pk;
+    bool focused;  // fitted to the focused box
+    std::future<SDL_Surface *> surface;
+    std::future<void> task;
+  };
+  std::list<PendingBox> _pending_boxes;
+
+  // Carousel transition: the layout is drawn shifted by an offset, in
+  // slots, easing from _slide_from to 0. Boxes pushed off either end slide
+  // out from their slots in _departing.
+  double _slide_from;
+  Uint32 _slide_start;
+  std::vector<std::pair<SDL_Surface *, int>> _departing;
+
+  // Main-thread work put off until it fits between frames, with flags so
+  // work already waiting isn't posted twice
+  FrameScheduler _deferred;
+  bool _headline_stale;
+  bool _watch_stale;
+  bool _speculation_stale;
+
+  // Text of the games either side of the focus, rasterized ahead of a move
+  // to them, by game id
+  std::map<int64_t, std::pair<SDL_Surface *, SDL_Surface *>> _ahead_text;
   
   // Surfaces
   SDL_Surface * _fbox_surface;
+  std::future<SDL_Surface *> _fbox_prefetch;  // started by the first game
+  std::future<void> _fbox_prefetch_task;
   std::list<SDL_Surface *> _left_surfaces;
   std::list<SDL_Surface *> _right_surfaces;
   int _left_size;  // size of _left_surfaces
   int _right_size; // size of _right_surfaces
   SDL_Surface * _headline;
   SDL_Surface * _subhead;
+  SDL_Surface * _status;
   SDL_Surface * _dots;
   
+  std::unique_ptr<Resource> _font_file;
   TTF_Font * _headline_font;
   TTF_Font * _subhead_font;
 
+  // Cold start work running in the background
+  std::future<SDL_Surface *> _background_load;
+  std::future<SDL_Surface *> _dots_load;
+  std::future<Fonts> _fonts_load;
+  std::promise<int> _fbox_pixel_width_known;  // once the window is open
+  std::shared_future<int> _fbox_pixel_width;
+  std::future<SDL_Surface *> _unused_prefetch;  // focus was restored elsewhere
+
+  // The last session, from launch until its focus is restored
+  std::unique_ptr<SavedSession> _saved_session;
+  bool _saved_frame_shown;
+  std::string _session_key;
+  std::future<void> _session_save;  // write in flight
+  unsigned _renders;  // render_all calls, so an unchanged screen isn't saved again
+  unsigned _slides;   // transitions started
+  unsigned _renders_saved;
+
   PLView _view;
 
 public:
-  PLViewWrapper() : _view(), _headline(nullptr), _subhead(nullptr) {
-    int result;
+  explicit PLViewWrapper(const std::vector<int> & sport_ids) : _feeds(sport_feeds(sport_ids), aspect_ratio_string, minimum_width), _refresher(_feeds, aspect_ratio_string, minimum_width, refresh_interval_seconds), _next_retry_ticks(0), _prev_retry_ticks(0), _paging(true), _searching(false), _filtered(false), _fgame(0), _begin_displayed(0), _end_displayed(0), _slide_from(0), _slide_start(0), _headline_stale(false), _watch_stale(false), _speculation_stale(false), _fbox_surface(nullptr), _headline(nullptr), _subhead(nullptr), _status(nullptr), _dots(nullptr), _headline_font(nullptr), _subhead_font(nullptr), _fbox_pixel_width(_fbox_pixel_width_known.get_future().share()), _saved_frame_shown(false), _renders(0), _slides(0), _renders_saved(0), _view() {
+    _feeds.set_on_update(wake_main_loop);
+  }
+
+  ~PLViewWrapper() {
+    IMG_Quit();
+    if (_headline_font != nullptr) {
+      TTF_CloseFont(_headline_font);
+      TTF_CloseFont(_subhead_font);
+      TTF_Quit();
+    }
+    end_slide();
+    while (has_deferred_work()) {
+      run_deferred(frame_ms);
+    }
+    free_surfaces();
+    free_ahead_text();
+    // finish downloads in flight now, while the view they're fitted to exists
+    for (auto & pending : _pending_boxes) {
+      SDL_FreeSurface(pending.surface.get());
+    }
+    if (_status != nullptr) {
+      SDL_FreeSurface(_status);
+    }
+    if (_dots != nullptr) {
+      SDL_FreeSurface(_dots);
+    }
+    if (_unused_prefetch.valid()) {
+      SDL_FreeSurface(_unused_prefetch.get());
+    }
+    if (_fbox_prefetch.valid()) {
+      SDL_FreeSurface(_fbox_prefetch.get());
+    }
+  }
 
+  // Cold start is a small dependency graph. Nothing but the window needs
+  // the main thread, and only the first image needs the window (for its
+  // pixel width), so fonts, the two fixed images and the schedule all load
+  // while the window opens:
+  //
+  //   image init --> background, dots ---------------+
+  //   fonts -----------------------------------------+--> first frame
+  //   schedule --------------------------------------+
+  //           \--> first image <-- window
+  //
+  // The first frame shows the dots in boxes whose images aren't in yet; the
+  // first image and the other boxes' images replace them as they arrive.
+  //
+  // Decoders are initialized first, on the main thread, since SDL_image's
+  // lazy initialization isn't thread-safe.
+  void init_image_loading() {
+    StartupSpan span("image init");
     int img_flags = IMG_INIT_JPG;
-    result = IMG_Init(img_flags);
-    if (result != img_flags) {
+    if (IMG_Init(img_flags) != img_flags) {
       error("could not initialize SDL_image");
     }
+  }
+
+  void start_loading_assets() {
+    _background_load = std::async(std::launch::async, load_image, background_filename);
+    _dots_load = std::async(std::launch::async, load_image, dots_filename);
+    _fonts_load = std::async(std::launch::async, open_fonts);
+  }
+
+  void open_window() {
+    StartupSpan span("window");
+    _view.open_window();
+    wake_event_type = SDL_RegisterEvents(1);
+    // text input is only wanted while typing a search
+    SDL_StopTextInput();
+    _fbox_pixel_width_known.set_value(_view.fbox_pixel_width());
+  }
+
+  void finish_loading_assets() {
+    StartupSpan span("wait for assets");
+    Fonts fonts = _fonts_load.get();
+    _font_file = std::move(fonts.file);
+    _headline_font = fonts.headline;
+    _subhead_font = fonts.subhead;
+    _dots = _view.fit_to_box(_dots_load.get(), false);
+    _view.set_background(_background_load.get());
+    if (!_saved_frame_shown) {
+      _view.show_background();
+    }
+  }
 
-    result = TTF_Init();
-    if (result != 0) {
-      error("Couldn't initialize TTF");
+  // A relaunch puts the last session's screen back up as soon as the window
+  // opens, then loads as usual: the catalog from its cache, revalidated in
+  // the background, and the session's photos instead of downloads.
+  void open_saved_session(const std::string & key) {
+    StartupSpan span("open session");
+    _session_key = key;
+    _saved_session.reset(new SavedSession(session_filename, key));
+    if (!_saved_session->is_valid()) {
+      _saved_session.reset();
     }
-    _headline_font = TTF_OpenFont(font_filename, headline_font_size);
-    if (_headline_font == nullptr) {
-      error("Couldn't open font");
+  }
+
+  // Date to start browsing at: the saved session's, or otherwise.
+  std::string resume_date(const std::string & otherwise) const {
+    return _saved_session && !_saved_session->date().empty() ? _saved_session->date() : otherwise;
+  }
+
+  void show_saved_frame() {
+    if (!_saved_session) {
+      return;
     }
-    _subhead_font = TTF_OpenFont(font_filename, subhead_font_size);
-    if (_subhead_font == nullptr) {
-      error("Couldn't open font");
+    StartupSpan span("saved frame");
+    SDL_Surface * frame = _saved_session->frame();
+    if (frame != nullptr) {
+      _view.show_still(frame);
+      SDL_FreeSurface(frame);
+      _saved_frame_shown = true;
     }
   }
 
-  ~PLViewWrapper() {
-    while (!_games.empty()) {
-      _games.pop_back();
+  // Once the games are in, focus the saved session's game and hand its
+  // photos to create_surfaces by catalog index. Games that changed since
+  // are replaced when the catalog is revalidated.
+  void restore_saved_focus() {
+    if (!_saved_session) {
+      return;
     }
-    IMG_Quit();
-    TTF_CloseFont(_headline_font);
-    TTF_CloseFont(_subhead_font);
-    TTF_Quit();
-    SDL_FreeSurface(_fbox_surface);
-    for (auto s : _left_surfaces) {
-      SDL_FreeSurface(s);
+    std::unordered_map<int64_t, size_t> index;  // game id to catalog index
+    for (size_t i = 0; i < _games.size(); i++) {
+      index.insert(std::make_pair(_games.game_pk(i), i));
     }
-    for (auto s : _right_surfaces) {
-      SDL_FreeSurface(s);
+    auto focused = index.find(_saved_session->focused_game_pk());
+    if (focused != index.end()) {
+      _fgame = focused->second;
+    }
+    if (_fgame != 0 && _fbox_prefetch.valid()) {
+      _unused_prefetch = std::move(_fbox_prefetch);
+    }
+    for (size_t b = 0; b < _saved_session->box_count(); b++) {
+      auto found = index.find(_saved_session->box_game_pk(b));
+      if (found != index.end() && _reusable.count(found->second) == 0) {
+        SDL_Surface * box = _saved_session->box(b);
+        if (box != nullptr) {
+          bool focused = found->second == _fgame;
+          _reusable[found->second] = _view.fit_to_box(box, focused);
+        }
+      }
     }
-    SDL_FreeSurface(_dots);
+    _saved_session.reset();
   }
 
-  void show_background(std::string filename) {
-    SDL_Surface * background = IMG_Load(filename.c_str());
-    if (background == NULL) {
-      error("could not load background");
-    }
-    _view.set_background(background);
+  // Copying the surfaces for a checkpoint is a burst of main-thread work,
+  // so the periodic one waits for a quiet frame.
+  void checkpoint_session_later() {
+    _deferred.post(FrameScheduler::idle, [this] {
+        checkpoint_session(false);
+      });
   }
-  
-  void load_games_from_json_url(std::string url) {
-    _games = get_photo_data_from_json_url(url, aspect_ratio_string, minimum_width);
-    _fgame = _games.begin();
+
+  // Save what is on screen for the next launch, if it changed since the
+  // last save. Surfaces are copied here and written in the background;
+  // with wait, as on exit, the write is finished before returning.
+  void checkpoint_session(bool wait) {
+    if (_session_save.valid()) {
+      if (!wait && !is_ready(_session_save)) {
+        return;
+      }
+      _session_save.get();
+    }
+    if (_renders != _renders_saved && _fbox_surface != nullptr && _fbox_surface != _dots
+        && !_session_key.empty() && !animating()) {
+      _renders_saved = _renders;
+      size_t focused_game = game_at(_fgame);
+      SessionState state;
+      state.key = _session_key;
+      state.date = _pages[page_of(focused_game)].date;
+      state.focused_game_pk = _games.game_pk(focused_game);
+      state.frame = SDL_DuplicateSurface(_view.frame());
+      state.boxes.push_back(std::make_pair(state.focused_game_pk,
+                                           SDL_DuplicateSurface(_fbox_surface)));
+      // boxes still showing the dots aren't worth restoring
+      size_t pos = _fgame;
+      for (auto s : _left_surfaces) {
+        pos--;
+        if (s != _dots) {
+          state.boxes.push_back(std::make_pair(_games.game_pk(game_at(pos)), SDL_DuplicateSurface(s)));
+        }
+      }
+      pos = _fgame;
+      for (auto s : _right_surfaces) {
+        pos++;
+        if (s != _dots) {
+          state.boxes.push_back(std::make_pair(_games.game_pk(game_at(pos)), SDL_DuplicateSurface(s)));
+        }
+      }
+      _session_save = std::async(std::launch::async, [state] {
+          save_session(session_filename, state);
+          SDL_FreeSurface(state.frame);
+          for (auto & box : state.boxes) {
+            SDL_FreeSurface(box.second);
+          }
+        });
+    }
+    if (wait && _session_save.valid()) {
+      _session_save.get();
+    }
   }
   
-  void create_headline_and_subhead() {
-    const SDL_Color white = {255, 255, 255, 255};
-    _headline = TTF_RenderUTF8_Solid(_headline_font,
-                                     _fgame->headline.c_str(),
-                                     white);
-    _subhead = TTF_RenderUTF8_Solid(_subhead_font,
-                                    _fgame->subhead.c_str(),
-                                    white);
-  }
-
-  void create_surfaces() {
-    _left_size = 0;
-    _right_size = 0;
+  // A cached catalog for this url is shown immediately and revalidated
+  // against the network in the background. Otherwise games are streamed out
+  // of the schedule as they arrive. The first one is the initial focus, so
+  // its image download starts right away, overlapping the rest of the
+  // schedule download. With several feeds, the first feed to arrive is
+  // shown and the others are merged in as they come.
+  void load_games_for_date(std::string date) {
+    if (_feeds.size() > 1) {
+      _games = _feeds.load(date);
+      if (_games.empty()) {
+        error("no games found in any feed");
+      }
+      _fgame = 0;
+      _pages.push_back(DatePage{date, _games.size()});
+      _search.sync(_games);
+      _facets.sync(_games);
+      watch_shown_dates();
+      _refresher.poll_now();  // cached feeds may be stale
+      return;
+    }
 
-    _fbox_surface = load_jpeg_from_url(_fgame->url);
+    std::string url = _feeds.url(0, date);
+    CatalogCache cache(url, aspect_ratio_string, minimum_width);
+    if (cache.load(_games) && !_games.empty()) {
+      _fgame = 0;
+      _pages.push_back(DatePage{date, _games.size()});
+      _search.sync(_games);
+      _facets.sync(_games);
+      watch_shown_dates();
+      _refresher.poll_now();  // the cached copy may be stale
+      return;
+    }
 
-    // Create displayed left boxes in right to left order
-    _begin_displayed = _fgame;
-    for (int i = 0; i < _view.n_displayed_each_side; i++) {
-      if (_begin_displayed == _games.begin()) {
-        break;
-      }
-      _begin_displayed--;
-      _left_surfaces.push_back(load_jpeg_from_url(_begin_displayed->url));
-      _left_size++;
+    stream_photo_data_from_json_url(url,
+                                    aspect_ratio_string,
+                                    minimum_width,
+                                    _games,
+                                    [this](size_t i) {
+                                      if (i == 0) {
+                                        prefetch_first_image();
+                                      }
+                                    });
+    if (_games.empty()) {
+      error("no games found in schedule");
     }
+    _fgame = 0;
+    _pages.push_back(DatePage{date, _games.size()});
+    cache.save(_games);
+    _search.sync(_games);
+    _facets.sync(_games);
+    watch_shown_dates();
+  }
 
-    // Create displayed right boxes in left to right order
-    _end_displayed = _fgame;
-    _end_displayed++;
-    for (int i = 0; i < _view.n_displayed_each_side; i++) {
-      if (_end_displayed == _games.end()) {
-        break;
+  // Start downloading the first game's image as soon as it has been parsed,
+  // which may be before the window is open. The game is copied, since the
+  // catalog is still growing.
+  void prefetch_first_image() {
+    Catalog first;
+    first.append(_games, 0, 1);
+    std::shared_future<int> pixel_width = _fbox_pixel_width;
+    const PLView * view = &_view;
+    _fbox_prefetch = start_and_wake<SDL_Surface *>([first, pixel_width, view] {
+        StartupSpan span("first image");
+        std::string url = select_cut(first, 0, aspect_ratio_string, pixel_width.get()).url;
+        return view->fit_to_box(load_jpeg_from_url(url), true);
+      }, _fbox_prefetch_task);
+  }
+
+  // Browse every date from first_date to last_date out of the season index,
+  // building it first if needed. The whole season stays loaded, so no dates
+  // are paged in or evicted.
+  void load_season(std::string first_date, std::string last_date) {
+    SeasonIndex index(first_date, last_date, aspect_ratio_string, minimum_width, schedule_url);
+    std::vector<SeasonIndex::DateEntry> dates;
+    if (!index.load(_games, dates)) {
+      index.update(season_index_threads);
+      if (!index.load(_games, dates)) {
+        error("couldn't build season index");
       }
-      _right_surfaces.push_back(load_jpeg_from_url(_end_displayed->url));
-      _right_size++;
-      _end_displayed++;
     }
+    if (_games.empty()) {
+      error("no games found in season");
+    }
+    for (const SeasonIndex::DateEntry & entry : dates) {
+      _pages.push_back(DatePage{entry.date, entry.count});
+    }
+    _fgame = 0;
+    _paging = false;
+    _search.sync(_games);
+    _facets.sync(_games);
+    watch_shown_dates();
+  }
 
-    create_headline_and_subhead();
+  // Index of the first game of the given page in _games.
+  size_t page_start(size_t page) const {
+    size_t start = 0;
+    for (size_t p = 0; p < page; p++) {
+      start += _pages[p].count;
+    }
+    return start;
+  }
 
-    _dots = IMG_Load(dots_filename.c_str());
-    if (_dots == nullptr) {
-      error("couldn't load dots");
+  // Start fetching the neighboring date in the background once the focus
+  // nears either end of the catalog. The catalog is only touched when the
+  // result is spliced in, by apply_loaded_pages.
+  void page_if_near_end() {
+    if (!_paging || _filtered) {
+      return;
+    }
+    Uint32 now = SDL_GetTicks();
+    if (_games.size() - _fgame <= page_ahead_games && !_next_page.valid()
+        && SDL_TICKS_PASSED(now, _next_retry_ticks)) {
+      _next_date = add_days(_pages.back().date, 1);
+      _next_page = start_and_wake<PageLoad>(std::bind(&PLViewWrapper::load_page, this, _next_date),
+                                            _next_page_task);
+    }
+    if (_fgame < page_ahead_games && !_prev_page.valid()
+        && SDL_TICKS_PASSED(now, _prev_retry_ticks)) {
+      _prev_date = add_days(_pages.front().date, -1);
+      _prev_page = start_and_wake<PageLoad>(std::bind(&PLViewWrapper::load_page, this, _prev_date),
+                                            _prev_page_task);
     }
   }
-    
-  void render_all() {
-    _view.render_all(_left_surfaces,
-                    _right_surfaces,
-                    _fbox_surface,
-                    _headline,
-                    _subhead);
+
+  // Runs in the background; only _feeds is touched.
+  PageLoad load_page(std::string date) {
+    PageLoad page;
+    page.games = _feeds.load(date, &page.failed);
+    return page;
   }
 
-  void move_right() {
-    bool new_image = false;
-    _fgame++;
-    if (_fgame == _games.end()) {
-      _fgame--;
-    } else {
-      if (_headline != nullptr) {
-        SDL_FreeSurface(_headline);
+  // Milliseconds until paging that is waiting after a failure may be
+  // retried, or -1 if none is waiting.
+  int ms_until_paging_retry() const {
+    Uint32 now = SDL_GetTicks();
+    int ms = -1;
+    for (Uint32 retry : {_next_retry_ticks, _prev_retry_ticks}) {
+      if (!SDL_TICKS_PASSED(now, retry)) {
+        int until = (int)(retry - now);
+        ms = ms < 0 ? until : std::min(ms, until);
       }
-      if (_subhead != nullptr) {
-        SDL_FreeSurface(_subhead);
-      }
-      create_headline_and_subhead();
-
-      // remove leftmost if left is full
+    }
+    return ms;
+  }
+
+  // Splice any finished neighboring dates into the catalog, keeping the
+  // focus on the same game, and fill in boxes that now have games to show.
+  // While filtered, positions aren't catalog indices, so finished dates
+  // wait until the filter is cleared.
+  void apply_loaded_pages() {
+    if (_filtered) {
+      return;
+    }
+    if (is_ready(_next_page)) {
+      PageLoad loaded = _next_page.get();
+      if (loaded.failed) {
+        _next_retry_ticks = SDL_GetTicks() + page_retry_seconds * 1000;
+      } else {
+        _games.append(loaded.games);
+        _pages.push_back(DatePage{_next_date, loaded.games.size()});
+        evict_far_pages();
+        fill_displayed();
+        apply_early_update(_next_date);
+      }
+    }
+    if (is_ready(_prev_page)) {
+      PageLoad loaded = _prev_page.get();
+      if (loaded.failed) {
+        _prev_retry_ticks = SDL_GetTicks() + page_retry_seconds * 1000;
+      } else {
+        Catalog page = std::move(loaded.games);
+        size_t n = page.size();
+        page.append(_games);
+        _games = std::move(page);
+        _pages.push_front(DatePage{_prev_date, n});
+        _search.clear();
+        _facets.clear();
+        _fgame += n;
+        _begin_displayed += n;
+        _end_displayed += n;
+        evict_far_pages();
+        fill_displayed();
+        apply_early_update(_prev_date);
+      }
+    }
+    page_if_near_end();
+    watch_shown_dates();
+  }
+
+  // Drop whole dates from whichever end is farther from the focus, never
+  // touching games that are displayed.
+  void evict_far_pages() {
+    while (_pages.size() > max_loaded_dates) {
+      size_t front_count = _pages.front().count;
+      size_t back_start = _games.size() - _pages.back().count;
+      bool can_evict_front = front_count <= _begin_displayed;
+      bool can_evict_back = back_start >= _end_displayed;
+      bool front_is_farther = _fgame >= _games.size() - 1 - _fgame;
+      if (can_evict_front && (front_is_farther || !can_evict_back)) {
+        _games.erase(0, front_count);
+        _search.clear();
+        _facets.clear();
+        _pages.pop_front();
+        _fgame -= front_count;
+        _begin_displayed -= front_count;
+        _end_displayed -= front_count;
+      } else if (can_evict_back) {
+        _games.erase(back_start, _games.size());
+        _search.clear();
+        _facets.clear();
+        _pages.pop_back();
+      } else {
+        break;
+      }
+    }
+  }
+
+  // Load boxes for displayed slots that have become available, e.g. after a
+  // date was spliced in next to the focus. If no game was shown, the loaded
+  // dates having had none, the new games are shown from the nearest.
+  void fill_displayed() {
+    if (_fbox_surface == nullptr && shown_count() > 0) {
+      show_focused(_fgame);
+      return;
+    }
+    bool changed = false;
+    while (_right_size < _view.n_displayed_each_side && _end_displayed < _games.size()) {
+      _right_surfaces.push_back(load_box_later(_end_displayed));
+      _right_size++;
+      _end_displayed++;
+      changed = true;
+    }
+    while (_left_size < _view.n_displayed_each_side && _begin_displayed > 0) {
+      _begin_displayed--;
+      _left_surfaces.push_back(load_box_later(_begin_displayed));
+      _left_size++;
+      changed = true;
+    }
+    if (changed) {
+      render_all();
+    }
+  }
+
+  // Dates the refresher keeps current: every loaded date while paging, and
+  // just the focused game's date when browsing a whole season.
+  void watch_shown_dates() {
+    std::vector<std::string> dates;
+    if (_paging) {
+      for (const DatePage & page : _pages) {
+        dates.push_back(page.date);
+      }
+    } else if (shown_count() > 0) {
+      dates.push_back(_pages[page_of(game_at(_fgame))].date);
+    }
+    if (dates != _watched_dates) {
+      _watched_dates = dates;
+      _refresher.watch(dates);
+      _feeds.retain(dates);
+    }
+  }
+
+  // Page holding the given catalog index.
+  size_t page_of(size_t game) const {
+    size_t page = 0;
+    size_t end = _pages[0].count;
+    while (game >= end && page + 1 < _pages.size()) {
+      page++;
+      end += _pages[page].count;
+    }
+    return page;
+  }
+
+  // Take per-game changes from the push endpoint at url instead of polling
+  // the schedule.
+  void follow_deltas(std::string url) {
+    _deltas.reset(new DeltaStream(url, aspect_ratio_string, minimum_width, wake_main_loop));
+    _refresher.set_periodic(false);
+  }
+
+  // Apply each pushed change to its date's page, if that date is loaded. A
+  // game already on the page is replaced where it is; a new one goes in by
+  // game time, after any starting at the same time, as the feeds are merged.
+  void apply_pushed_deltas() {
+    if (!_deltas) {
+      return;
+    }
+    GameDelta delta;
+    while (_deltas->take(delta)) {
+      size_t page = find_page(delta.date);
+      if (page == _pages.size()) {
+        continue;
+      }
+      size_t start = page_start(page);
+      size_t end = start + _pages[page].count;
+      bool listed = false;
+      for (size_t i = start; i < end && !listed; i++) {
+        listed = _games.game_pk(i) == delta.game_pk;
+      }
+      std::string time = delta.removed ? "" : delta.game.str(delta.game.game_time_ref(0));
+      Catalog updated;
+      bool placed = delta.removed;  // a removal has nothing to place
+      for (size_t i = start; i < end; i++) {
+        if (!placed && !listed && _games.str(_games.game_time_ref(i)) > time) {
+          updated.append(delta.game);
+          placed = true;
+        }
+        if (_games.game_pk(i) != delta.game_pk) {
+          updated.append(_games, i, i + 1);
+        } else if (!placed) {
+          updated.append(delta.game);
+          placed = true;
+        }
+      }
+      if (!placed) {
+        updated.append(delta.game);
+      }
+      apply_refresh(delta.date, updated);
+    }
+  }
+
+  // Index in _pages of the given date, or _pages.size() if it isn't loaded.
+  size_t find_page(const std::string & date) const {
+    size_t page = 0;
+    while (page < _pages.size() && _pages[page].date != date) {
+      page++;
+    }
+    return page;
+  }
+
+  // Show the dates whose merged catalog changed, because the refresher
+  // found a feed changed or a slow feed arrived.
+  void apply_refreshed_games() {
+    std::string date;
+    Catalog games;
+    while (_feeds.take_update(date, games)) {
+      bool paging_in = (_next_page.valid() && date == _next_date)
+        || (_prev_page.valid() && date == _prev_date);
+      if (paging_in && find_page(date) == _pages.size()) {
+        _early_updates[date] = std::move(games);
+      } else {
+        apply_refresh(date, games);
+      }
+    }
+  }
+
+  void apply_early_update(const std::string & date) {
+    auto found = _early_updates.find(date);
+    if (found != _early_updates.end()) {
+      Catalog games = std::move(found->second);
+      _early_updates.erase(found);
+      apply_refresh(date, games);
+    }
+  }
+
+  // Games are matched to the shown ones by game id. Games whose photo and
+  // text are unchanged keep their surfaces, only changed or new games load
+  // images, and the focus stays on the same game, even if its photo changed.
+  // A date left with no games, its last one postponed or removed, stays
+  // loaded as an empty page, like a date with no games to begin with.
+  void apply_refresh(const std::string & date, const Catalog & fresh) {
+    size_t page = find_page(date);
+    if (page == _pages.size()) {
+      return;  // evicted while refreshing
+    }
+    size_t start = page_start(page);
+    size_t end = start + _pages[page].count;
+
+    std::unordered_map<int64_t, size_t> shown;  // game id to catalog index
+    for (size_t i = start; i < end; i++) {
+      shown[_games.game_pk(i)] = i;
+    }
+    std::unordered_map<size_t, size_t> unchanged;  // old index to new
+    std::unordered_map<int64_t, size_t> fresh_index;  // game id to new index
+    for (size_t j = 0; j < fresh.size(); j++) {
+      fresh_index[fresh.game_pk(j)] = start + j;
+      auto found = shown.find(fresh.game_pk(j));
+      if (found != shown.end() && same_photo(_games, found->second, fresh, j)) {
+        unchanged[found->second] = start + j;
+      }
+    }
+    bool same_order = fresh.size() == end - start && unchanged.size() == fresh.size();
+    for (auto & entry : unchanged) {
+      same_order = same_order && entry.first == entry.second;
+    }
+    if (same_order) {
+      return;
+    }
+
+    // where the focused game ends up
+    bool has_focus = shown_count() > 0;
+    size_t focused_game = has_focus ? game_at(_fgame) : 0;
+    if (focused_game >= end) {
+      focused_game = focused_game - end + start + fresh.size();
+    } else if (focused_game >= start) {
+      auto found = fresh_index.find(_games.game_pk(focused_game));
+      if (found != fresh_index.end()) {
+        focused_game = found->second;
+      } else if (!fresh.empty()) {
+        focused_game = start + std::min(focused_game - start, fresh.size() - 1);
+      } else {
+        // the page emptied: focus the game after it, or the one before
+        bool after = start < _games.size() - (end - start);
+        focused_game = after || start == 0 ? start : start - 1;
+      }
+    }
+
+    // carry surfaces over to the games' new indices
+    stash_displayed_surfaces();
+    std::map<size_t, SDL_Surface *> reusable;
+    for (auto & entry : _reusable) {
+      size_t i = entry.first;
+      if (i < start) {
+        reusable[i] = entry.second;
+      } else if (i >= end) {
+        reusable[i - end + start + fresh.size()] = entry.second;
+      } else if (unchanged.count(i) != 0) {
+        reusable[unchanged[i]] = entry.second;
+      } else {
+        SDL_FreeSurface(entry.second);
+      }
+    }
+    _reusable.swap(reusable);
+
+    Catalog spliced;
+    spliced.append(_games, 0, start);
+    spliced.append(fresh);
+    spliced.append(_games, end, _games.size());
+    _games = std::move(spliced);
+    _search.clear();
+    _facets.clear();
+    _pages[page].count = fresh.size();
+    find_matches();
+    show_focused(has_focus ? focused_game : 0);
+  }
+  
+  // Each box downloads the smallest cut that covers its drawn size, so side
+  // boxes fetch fewer bytes and the focused box stays sharp. The box shows
+  // the dots until its image is in; nothing waits for it. The first game's
+  // focused image may already be on its way from cold start.
+  SDL_Surface * load_box_later(size_t pos, bool focused = false) {
+    size_t game = game_at(pos);
+    _games.set_state(game, photo_loaded);
+    SDL_Surface * surface = take_reusable(game);
+    if (surface != nullptr) {
+      return surface;
+    }
+    if (focused && game == 0 && _fbox_prefetch.valid()) {
+      PendingBox pending;
+      pending.game_pk = _games.game_pk(game);
+      pending.focused = true;
+      pending.surface = std::move(_fbox_prefetch);
+      pending.task = std::move(_fbox_prefetch_task);
+      _pending_boxes.push_back(std::move(pending));
+    } else {
+      start_pending_load(game, focused);
+    }
+    return _dots;
+  }
+
+  void start_pending_load(size_t game, bool focused) {
+    int pixel_width = focused ? _view.fbox_pixel_width() : _view.box_pixel_width();
+    std::string url = select_cut(_games, game, aspect_ratio_string, pixel_width).url;
+    const PLView * view = &_view;
+    PendingBox pending;
+    pending.game_pk = _games.game_pk(game);
+    pending.focused = focused;
+    pending.surface = start_and_wake<SDL_Surface *>([url, focused, view] {
+        return view->fit_to_box(load_jpeg_from_url(url), focused);
+      }, pending.task);
+    _pending_boxes.push_back(std::move(pending));
+  }
+
+  bool has_pending_load(int64_t game_pk, bool focused) const {
+    for (auto & pending : _pending_boxes) {
+      if (pending.game_pk == game_pk && pending.focused == focused) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Swap in box images that finished downloading where their game is still
+  // displayed, in place of the dots or of a smaller image in the focused box.
+  // A box whose download failed keeps what it shows, and is tried again
+  // when it is next displayed.
+  void apply_loaded_boxes() {
+    TRACE_SPAN("apply_loaded_boxes");
+    bool changed = false;
+    for (auto it = _pending_boxes.begin(); it != _pending_boxes.end(); ) {
+      if (!is_ready(it->surface)) {
+        ++it;
+        continue;
+      }
+      SDL_Surface * surface = it->surface.get();
+      SDL_Surface ** slot = displayed_slot(it->game_pk);
+      if (surface != nullptr && slot != nullptr && (*slot == _dots || (*slot)->w < surface->w)) {
+        free_box(*slot);
+        *slot = surface;
+        changed = true;
+      } else {
+        SDL_FreeSurface(surface);
+      }
+      it = _pending_boxes.erase(it);
+    }
+    if (changed && !animating()) {
+      render_all();
+    }
+  }
+
+  // Where the displayed surface of the given game is kept, or null.
+  SDL_Surface ** displayed_slot(int64_t game_pk) {
+    if (shown_count() == 0) {
+      return nullptr;
+    }
+    if (_games.game_pk(game_at(_fgame)) == game_pk) {
+      return &_fbox_surface;
+    }
+    size_t pos = _fgame;
+    for (auto & s : _left_surfaces) {
+      if (_games.game_pk(game_at(--pos)) == game_pk) {
+        return &s;
+      }
+    }
+    pos = _fgame;
+    for (auto & s : _right_surfaces) {
+      if (_games.game_pk(game_at(++pos)) == game_pk) {
+        return &s;
+      }
+    }
+    return nullptr;
+  }
+
+  // The dots are shared by every box still loading.
+  void free_box(SDL_Surface * surface) {
+    if (surface != _dots) {
+      SDL_FreeSurface(surface);
+    }
+  }
+
+  SDL_Surface * take_reusable(size_t game) {
+    auto found = _reusable.find(game);
+    if (found == _reusable.end()) {
+      return nullptr;
+    }
+    SDL_Surface * surface = found->second;
+    _reusable.erase(found);
+    return surface;
+  }
+
+  size_t shown_count() const {
+    return _filtered ? _matches.size() : _games.size();
+  }
+
+  size_t game_at(size_t pos) const {
+    return _filtered ? _matches[pos] : pos;
+  }
+
+  // An item that gains focus may still be showing the smaller image it was
+  // loaded with as a side box. Show that, scaled up, until the larger cut
+  // has downloaded.
+  void upgrade_fbox() {
+    if (_fbox_surface == nullptr || _fbox_surface->w >= _view.fbox_width()) {
+      return;
+    }
+    size_t game = game_at(_fgame);
+    if (!has_pending_load(_games.game_pk(game), true)) {
+      start_pending_load(game, true);
+    }
+  }
+
+  // A transition is under way: frames are due every frame_ms until it ends.
+  bool animating() const {
+    return _slide_from != 0;
+  }
+
+  // Offset of the layout, in slots, at the given time: eased out, so the
+  // carousel moves quickly at first and settles into place. The tail of the
+  // easing, under half a pixel from the end, is left out: those frames
+  // would look settled without matching the settled frame.
+  double slide_offset(Uint32 now) const {
+    double t = (now - _slide_start) / transition_ms;
+    double offset = t >= 1 ? 0 : _slide_from * std::pow(1 - t, 3);
+    return std::abs(offset) * _view.slot_pitch() < 0.5 ? 0 : offset;
+  }
+
+  // Start sliding the carousel into its new layout from distance slots
+  // away, continuing from wherever a transition under way had got to.
+  void start_slide(int distance) {
+    Uint32 now = SDL_GetTicks();
+    _slide_from = slide_offset(now) + distance;
+    _slide_start = now;
+    _slides++;
+    for (auto & d : _departing) {
+      d.second -= distance;
+    }
+  }
+
+  void depart(SDL_Surface * surface, int slot) {
+    _departing.push_back(std::make_pair(surface, slot));
+  }
+
+  // Draw the next frame of the transition, ending it once it has settled.
+  void render_frame() {
+    if (slide_offset(SDL_GetTicks()) == 0) {
+      _slide_from = 0;
+      // off screen now; freeing them can wait for a quiet frame
+      std::vector<std::pair<SDL_Surface *, int>> departed;
+      departed.swap(_departing);
+      _deferred.post(FrameScheduler::idle, [this, departed] {
+          for (auto & d : departed) {
+            free_box(d.first);
+          }
+        });
+    }
+    render_all();
+  }
+
+  void set_pipelined(bool pipelined) {
+    _view.set_pipelined(pipelined);
+  }
+
+  void set_offscreen(int w, int h) {
+    _view.set_offscreen(w, h);
+  }
+
+  void on_present(std::function<void(const PLView::PresentTiming &)> callback) {
+    _view.on_present(callback);
+  }
+
+  // Nothing under way would change the frame without further input. Pages
+  // aren't applied while filtered, so don't count then.
+  bool is_settled() const {
+    return !animating() && _pending_boxes.empty() && !has_deferred_work()
+      && (_filtered || (!_next_page.valid() && !_prev_page.valid()));
+  }
+
+  SDL_Surface * frame() {
+    return _view.frame();
+  }
+
+  // Counts what input can change on screen, frames rendered and
+  // transitions started, for telling whether it did.
+  unsigned changes() const {
+    return _renders + _slides;
+  }
+
+  // See PLView::present_composed.
+  bool present_composed() {
+    return _view.present_composed();
+  }
+
+  void flush_frames() {
+    _view.flush();
+  }
+
+  PLView::RenderStats take_render_stats() {
+    return _view.take_render_stats();
+  }
+
+  // Runs deferred main-thread work for up to budget_ms. See FrameScheduler.
+  FrameScheduler::Stats run_deferred(double budget_ms) {
+    return _deferred.run(budget_ms);
+  }
+
+  bool has_deferred_work() const {
+    return _deferred.backlog() > 0;
+  }
+
+  // Rasterizing the new focus's text is left for after the move's first
+  // frame. Moves in quick succession render it once, for the last.
+  void refresh_headline_later() {
+    if (_headline_stale) {
+      return;
+    }
+    _headline_stale = true;
+    _deferred.post(FrameScheduler::urgent, [this] {
+        _headline_stale = false;
+        if (_headline != nullptr) {
+          SDL_FreeSurface(_headline);
+        }
+        if (_subhead != nullptr) {
+          SDL_FreeSurface(_subhead);
+        }
+        create_headline_and_subhead();
+        if (!animating()) {
+          render_all();
+        }
+      });
+  }
+
+  void watch_shown_dates_later() {
+    if (_watch_stale) {
+      return;
+    }
+    _watch_stale = true;
+    _deferred.post(FrameScheduler::soon, [this] {
+        _watch_stale = false;
+        watch_shown_dates();
+      });
+  }
+
+  void create_headline_and_subhead() {
+    auto ahead = _ahead_text.find(_games.game_pk(game_at(_fgame)));
+    if (ahead != _ahead_text.end()) {
+      _headline = ahead->second.first;
+      _subhead = ahead->second.second;
+      _ahead_text.erase(ahead);
+      return;
+    }
+    render_text(game_at(_fgame), _headline, _subhead);
+  }
+
+  void render_text(size_t game, SDL_Surface *& headline, SDL_Surface *& subhead) {
+    TRACE_SPAN("render_text");
+    const SDL_Color white = {255, 255, 255, 255};
+    headline = TTF_RenderUTF8_Solid(_headline_font, _games.headline(game).c_str(), white);
+    subhead = TTF_RenderUTF8_Solid(_subhead_font, _games.subhead(game).c_str(), white);
+  }
+
+  void free_ahead_text() {
+    for (auto & entry : _ahead_text) {
+      SDL_FreeSurface(entry.second.first);
+      SDL_FreeSurface(entry.second.second);
+    }
+    _ahead_text.clear();
+  }
+
+  void create_surfaces() {
+    free_ahead_text();  // the games' text may have changed
+    _left_size = 0;
+    _right_size = 0;
+    _begin_displayed = _fgame;
+    _end_displayed = _fgame;
+    if (shown_count() == 0) {
+      return;
+    }
+
+    size_t n_side = _view.n_displayed_each_side;
+    _begin_displayed = _fgame >= n_side ? _fgame - n_side : 0;
+    _end_displayed = std::min(shown_count(), _fgame + 1 + n_side);
+
+    _fbox_surface = load_box_later(_fgame, true);
+    // left boxes in right to left order, right boxes in left to right order
+    for (size_t pos = _fgame; pos > _begin_displayed; pos--) {
+      _left_surfaces.push_back(load_box_later(pos - 1));
+      _left_size++;
+    }
+    for (size_t pos = _fgame + 1; pos < _end_displayed; pos++) {
+      _right_surfaces.push_back(load_box_later(pos));
+      _right_size++;
+    }
+
+    create_headline_and_subhead();
+  }
+
+  void free_surfaces() {
+    for (size_t i = _begin_displayed; i < _end_displayed && i < shown_count(); i++) {
+      _games.set_state(game_at(i), photo_unloaded);
+    }
+    if (_fbox_surface != nullptr) {
+      free_box(_fbox_surface);
+      _fbox_surface = nullptr;
+    }
+    for (auto s : _left_surfaces) {
+      free_box(s);
+    }
+    _left_surfaces.clear();
+    for (auto s : _right_surfaces) {
+      free_box(s);
+    }
+    _right_surfaces.clear();
+    if (_headline != nullptr) {
+      SDL_FreeSurface(_headline);
+      _headline = nullptr;
+    }
+    if (_subhead != nullptr) {
+      SDL_FreeSurface(_subhead);
+      _subhead = nullptr;
+    }
+  }
+    
+  void render_all() {
+    _renders++;
+    _view.render_all(current_layout());
+    if (!animating()) {
+      speculate_later();
+    }
+  }
+
+  PLView::Layout current_layout() const {
+    PLView::Layout layout;
+    layout.left_boxes = _left_surfaces;
+    layout.right_boxes = _right_surfaces;
+    layout.fbox = _fbox_surface;
+    layout.headline = _headline;
+    layout.subhead = _subhead;
+    layout.status = _status;
+    layout.offset = slide_offset(SDL_GetTicks());
+    layout.departing = _departing;
+    layout.loading = shows_dots(layout);
+    return layout;
+  }
+
+  bool shows_dots(const PLView::Layout & layout) const {
+    return layout.fbox == _dots
+      || std::find(layout.left_boxes.begin(), layout.left_boxes.end(), _dots) != layout.left_boxes.end()
+      || std::find(layout.right_boxes.begin(), layout.right_boxes.end(), _dots) != layout.right_boxes.end();
+  }
+
+  // Only a move left or right can come next, so once the screen settles
+  // the view composes the frames either move would settle on. For those to
+  // match, the neighbours' text is rasterized now and their photos fetched
+  // at the focused size; both are used when the move happens.
+  void speculate_later() {
+    if (_speculation_stale) {
+      return;
+    }
+    _speculation_stale = true;
+    _deferred.post(FrameScheduler::idle, [this] {
+        _speculation_stale = false;
+        speculate();
+      });
+  }
+
+  void speculate() {
+    if (animating() || _fbox_surface == nullptr) {
+      return;
+    }
+    std::vector<PLView::Layout> layouts;
+    std::map<int64_t, std::pair<SDL_Surface *, SDL_Surface *>> ahead_text;
+    for (int direction : {1, -1}) {
+      if (direction > 0 ? _fgame + 1 < shown_count() : _fgame > 0) {
+        size_t game = game_at(_fgame + direction);
+        int64_t game_pk = _games.game_pk(game);
+        auto found = _ahead_text.find(game_pk);
+        if (found != _ahead_text.end()) {
+          ahead_text.insert(*found);
+          _ahead_text.erase(found);
+        } else {
+          render_text(game, ahead_text[game_pk].first, ahead_text[game_pk].second);
+        }
+        layouts.push_back(layout_after_move(direction, ahead_text[game_pk]));
+      }
+    }
+    free_ahead_text();
+    _ahead_text.swap(ahead_text);
+    _view.speculate(layouts);
+  }
+
+  // How the screen settles after a move in the given direction; see
+  // move_right and move_left.
+  PLView::Layout layout_after_move(int direction, std::pair<SDL_Surface *, SDL_Surface *> text) {
+    PLView::Layout layout = current_layout();
+    layout.offset = 0;
+    layout.departing.clear();
+    layout.headline = text.first;
+    layout.subhead = text.second;
+    std::list<SDL_Surface *> & behind = direction > 0 ? layout.left_boxes : layout.right_boxes;
+    std::list<SDL_Surface *> & ahead = direction > 0 ? layout.right_boxes : layout.left_boxes;
+    behind.push_front(layout.fbox);
+    if (behind.size() > (size_t)_view.n_displayed_each_side) {
+      behind.pop_back();
+    }
+    layout.fbox = ahead.front();
+    ahead.pop_front();
+    if (direction > 0 ? _end_displayed != shown_count() : _begin_displayed != 0) {
+      ahead.push_back(_dots);
+    }
+
+    // fetched now, the focused size is in before the move asks for it
+    size_t game = game_at(_fgame + direction);
+    if (layout.fbox != _dots && layout.fbox->w < _view.fbox_width()
+        && !has_pending_load(_games.game_pk(game), true)) {
+      start_pending_load(game, true);
+    }
+    layout.loading = shows_dots(layout);
+    return layout;
+  }
+
+  bool is_searching() const { return _searching; }
+  bool is_filtered() const { return _filtered; }
+
+  // Start taking a query. Typed text arrives through search_append.
+  void begin_search() {
+    _searching = true;
+    SDL_StartTextInput();
+    update_filter();
+  }
+
+  // Stop taking text. The results stay shown unless keep_results is false,
+  // in which case the whole catalog is shown again, still focused on the
+  // same game.
+  void end_search(bool keep_results) {
+    _searching = false;
+    SDL_StopTextInput();
+    if (!keep_results) {
+      _query.clear();
+    }
+    update_filter();
+  }
+
+  void search_append(const char * text) {
+    if (!_searching) {
+      return;
+    }
+    _query += text;
+    update_filter();
+  }
+
+  void search_backspace() {
+    if (_query.empty()) {
+      return;
+    }
+    // drop a whole UTF-8 sequence
+    while (!_query.empty() && (_query.back() & 0xC0) == 0x80) {
+      _query.pop_back();
+    }
+    if (!_query.empty()) {
+      _query.pop_back();
+    }
+    update_filter();
+  }
+
+  // Facet filters on the focused game. Each key cycles its facet between
+  // the focused game's value(s) and no restriction.
+  void toggle_team_filter() {
+    std::vector<std::string> teams = _selection.teams;
+    _selection.teams.clear();
+    if (shown_count() > 0) {
+      GameInfo game = _games.game(game_at(_fgame));
+      if (teams.empty()) {
+        _selection.teams.push_back(game.away_team);
+      } else if (teams[0] == game.away_team && game.home_team != game.away_team) {
+        _selection.teams.push_back(game.home_team);
+      }
+    }
+    update_filter();
+  }
+
+  void toggle_venue_filter() {
+    bool was_set = !_selection.venues.empty();
+    _selection.venues.clear();
+    if (!was_set && shown_count() > 0) {
+      _selection.venues.push_back(_games.game(game_at(_fgame)).venue);
+    }
+    update_filter();
+  }
+
+  // Restrict to the focused game's date, or its month with whole_month.
+  void toggle_date_filter(bool whole_month) {
+    std::string first;
+    std::string last;
+    if (shown_count() > 0) {
+      std::string date = _games.game(game_at(_fgame)).date;
+      first = whole_month ? date.substr(0, 8) + "01" : date;
+      last = whole_month ? date.substr(0, 8) + "31" : date;
+    }
+    if (_selection.first_date == first && _selection.last_date == last) {
+      first.clear();
+      last.clear();
+    }
+    _selection.first_date = first;
+    _selection.last_date = last;
+    update_filter();
+  }
+
+  void clear_filters() {
+    _query.clear();
+    _selection = FacetIndex::Selection();
+    update_filter();
+  }
+
+  // Narrow the carousel to the games matching the query and facet
+  // selection, keeping the focus on the same game when it matches,
+  // otherwise moving it to the next match.
+  void update_filter() {
+    bool has_focus = shown_count() > 0;
+    size_t focused_game = has_focus ? game_at(_fgame) : 0;
+    stash_displayed_surfaces();
+    find_matches();
+    show_focused(has_focus ? focused_game : 0);
+  }
+
+  // Set _matches for the current query and facet selection.
+  void find_matches() {
+    bool faceted = !_selection.empty();
+    _filtered = faceted || !_query.empty();
+    _matches.clear();
+    if (faceted) {
+      _facets.sync(_games);
+      _facets.select(_selection, _matches, _facet_counts);
+    }
+    if (!_query.empty()) {
+      _search.sync(_games);
+      const std::vector<uint32_t> & found = _search.search(_games, _query);
+      if (faceted) {
+        std::vector<uint32_t> both;
+        std::set_intersection(_matches.begin(), _matches.end(),
+                              found.begin(), found.end(),
+                              std::back_inserter(both));
+        _matches.swap(both);
+      } else {
+        _matches = found;
+      }
+    }
+  }
+
+  // Recreate the displayed surfaces around the given catalog index, or the
+  // next shown game if it isn't shown. Surfaces stashed in _reusable are
+  // used where they fit and freed otherwise.
+  void show_focused(size_t focused_game) {
+    if (!_filtered) {
+      _fgame = _games.empty() ? 0 : std::min(focused_game, _games.size() - 1);
+    } else {
+      _fgame = std::lower_bound(_matches.begin(), _matches.end(), focused_game) - _matches.begin();
+      if (_fgame == _matches.size() && _fgame > 0) {
+        _fgame--;
+      }
+    }
+    create_status();
+    create_surfaces();
+    free_reusable_surfaces();
+    upgrade_fbox();
+    render_all();
+    page_if_near_end();
+    watch_shown_dates();
+  }
+
+  void create_status() {
+    if (_status != nullptr) {
+      SDL_FreeSurface(_status);
+      _status = nullptr;
+    }
+    if (!_searching && !_filtered) {
+      return;
+    }
+    const SDL_Color white = {255, 255, 255, 255};
+    std::string text;
+    for (const std::string & team : _selection.teams) {
+      text += team + "  ";
+    }
+    for (const std::string & venue : _selection.venues) {
+      text += "at " + venue + "  ";
+    }
+    if (!_selection.first_date.empty()) {
+      text += _selection.first_date == _selection.last_date
+        ? _selection.first_date : _selection.first_date.substr(0, 7);
+      text += "  ";
+    }
+    if (_searching || !_query.empty()) {
+      text += "Search: " + _query + (_searching ? "_" : "") + "  ";
+    }
+    text += "(" + std::to_string(_matches.size()) + " of " + std::to_string(_games.size()) + ")";
+    // without a query the counts cover exactly the games shown
+    if (!_selection.empty() && _query.empty()) {
+      text += "  " + describe_count(FacetIndex::facet_venue, "venue")
+        + "  " + describe_count(FacetIndex::facet_date, "date");
+    }
+    TRACE_SPAN("render_status");
+    _status = TTF_RenderUTF8_Solid(_subhead_font, text.c_str(), white);
+  }
+
+  // Number of distinct values of the facet among the selected games.
+  std::string describe_count(FacetIndex::Facet facet, const std::string & noun) const {
+    size_t n = 0;
+    for (uint32_t count : _facet_counts.values[facet]) {
+      if (count > 0) {
+        n++;
+      }
+    }
+    return std::to_string(n) + " " + noun + (n == 1 ? "" : "s");
+  }
+
+  // Move the displayed surfaces into _reusable, keyed by game, before the
+  // shown sequence changes.
+  void stash_displayed_surfaces() {
+    if (_fbox_surface != nullptr && _fbox_surface != _dots) {
+      _reusable[game_at(_fgame)] = _fbox_surface;
+    }
+    _fbox_surface = nullptr;
+    size_t pos = _fgame;
+    for (auto s : _left_surfaces) {
+      pos--;
+      if (s != _dots) {
+        _reusable[game_at(pos)] = s;
+      }
+    }
+    _left_surfaces.clear();
+    pos = _fgame;
+    for (auto s : _right_surfaces) {
+      pos++;
+      if (s != _dots) {
+        _reusable[game_at(pos)] = s;
+      }
+    }
+    _right_surfaces.clear();
+    end_slide();
+    free_surfaces();
+  }
+
+  // Settle a transition under way at once, as when the layout is rebuilt.
+  void end_slide() {
+    _slide_from = 0;
+    for (auto & d : _departing) {
+      free_box(d.first);
+    }
+    _departing.clear();
+  }
+
+  void free_reusable_surfaces() {
+    for (auto & entry : _reusable) {
+      _games.set_state(entry.first, photo_unloaded);
+      SDL_FreeSurface(entry.second);
+    }
+    _reusable.clear();
+  }
+
+  // Moves don't wait on downloads: a box coming into view shows the dots
+  // until its image is in, and the carousel slides over to its new layout
+  // one frame at a time from the controller's loop.
+  void move_right() {
+    if (_fgame + 1 < shown_count()) {
+      _fgame++;
+
+      refresh_headline_later();
+      start_slide(1);
+
+      // remove leftmost if left is full, sliding it out past the edge
       if (_left_size == _view.n_displayed_each_side) {
-        SDL_FreeSurface(_left_surfaces.back());
+        depart(_left_surfaces.back(), -(int)_view.n_displayed_each_side - 1);
+        _games.set_state(game_at(_begin_displayed), photo_unloaded);
         _begin_displayed++;
         _left_surfaces.pop_back();
         _left_size--;
@@ -357,34 +2325,29 @@ public:
       _right_size--;
 
       // if there's a new rightmost, grab it
-      if (_end_displayed != _games.end()) {
+      if (_end_displayed != shown_count()) {
         _right_size++;
-        _right_surfaces.push_back(_dots);
-        render_all();
-        _right_surfaces.pop_back();
-        _right_surfaces.push_back(load_jpeg_from_url(_end_displayed->url));
+        _right_surfaces.push_back(load_box_later(_end_displayed));
         _end_displayed++;
       }
-      render_all();
+      upgrade_fbox();
+      page_if_near_end();
+      watch_shown_dates_later();
     }
   }
 
   void move_left() {
-    if (_fgame != _games.begin()) {
+    if (_fgame != 0) {
       _fgame--;
 
-      if (_headline != nullptr) {
-        SDL_FreeSurface(_headline);
-      }
-      if (_subhead != nullptr) {
-        SDL_FreeSurface(_subhead);
-      }
-      create_headline_and_subhead();
+      refresh_headline_later();
+      start_slide(-1);
 
-      // remove rightmost if right is full
+      // remove rightmost if right is full, sliding it out past the edge
       if (_right_size == _view.n_displayed_each_side) {
-        SDL_FreeSurface(_right_surfaces.back());
+        depart(_right_surfaces.back(), (int)_view.n_displayed_each_side + 1);
         _end_displayed--;
+        _games.set_state(game_at(_end_displayed), photo_unloaded);
         _right_surfaces.pop_back();
         _right_size--;
       }
@@ -399,16 +2362,15 @@ public:
       _left_size--;
 
       // if there's a new leftmost, grab it
-      if (_begin_displayed != _games.begin()) {
+      if (_begin_displayed != 0) {
         _begin_displayed--;
         _left_size++;
-        _left_surfaces.push_back(_dots);
-        render_all();
-        _left_surfaces.pop_back();
-        _left_surfaces.push_back(load_jpeg_from_url(_begin_displayed->url));
+        _left_surfaces.push_back(load_box_later(_begin_displayed));
       }
 
-      render_all();
+      upgrade_fbox();
+      page_if_near_end();
+      watch_shown_dates_later();
     }
   }
 };
@@ -416,47 +2378,587 @@ public:
 class PLController : Uncopyable {
 private:
   PLViewWrapper _view_wrapper;
+  std::string _season_first_date;  // empty unless browsing a season index
+  std::string _season_last_date;
+  std::string _push_url;  // empty unless following pushed deltas
+  std::vector<int> _sport_ids;
+  WakeupStats _wakeups;
+  FrameClock _frames;
+  InputLatency _input_latency;
+  bool _report_deferred;
+  Uint32 _last_input_ticks;
+  bool _headless;
+  std::vector<ScriptStep> _script;
+  size_t _next_step;
+  Uint32 _step_ticks;  // when the next step was first tried, or 0
+  std::unique_ptr<ShotRecorder> _shots;  // null unless playing a script
+  double _first_paint_ms;   // since the process started, or -1 until then
+  double _all_visible_ms;   // first frame with every box's photo in, or -1
+  double _loading_since_ms; // when the dots were last presented, or -1
+  double _loading_ms;       // total time the dots were on screen
 
 public:
-  PLController() : _view_wrapper() {
+  explicit PLController(const std::vector<int> & sport_ids) : _view_wrapper(sport_ids), _sport_ids(sport_ids), _frames(frame_ms), _report_deferred(false), _last_input_ticks(0), _headless(false), _next_step(0), _step_ticks(0), _first_paint_ms(-1), _all_visible_ms(-1), _loading_since_ms(-1), _loading_ms(0) {
   }
 
-  void run() {
-    _view_wrapper.show_background(background_filename);
-    _view_wrapper.load_games_from_json_url(json_url);
+  // A saved session is only restored by a launch showing the same feeds.
+  std::string session_key() const {
+    std::string key = "sports";
+    for (int sport_id : _sport_ids) {
+      key += " " + std::to_string(sport_id);
+    }
+    if (!_season_first_date.empty()) {
+      key += "\nseason " + _season_first_date + " " + _season_last_date;
+    }
+    return key;
+  }
+
+  // While searching, letters are query text, not commands.
+  void handle_search_key(SDL_Keycode key) {
+    switch (key) {
+    case SDLK_LEFT:
+      _view_wrapper.move_left();
+      break;
+    case SDLK_RIGHT:
+      _view_wrapper.move_right();
+      break;
+    case SDLK_BACKSPACE:
+      _view_wrapper.search_backspace();
+      break;
+    case SDLK_RETURN:
+      _view_wrapper.end_search(true);
+      break;
+    case SDLK_ESCAPE:
+      _view_wrapper.end_search(false);
+      break;
+    }
+  }
+
+  void set_season(std::string first_date, std::string last_date) {
+    _season_first_date = first_date;
+    _season_last_date = last_date;
+  }
+
+  void set_push_url(std::string url) {
+    _push_url = url;
+  }
+
+  void report_wakeups() {
+    _wakeups.enable_report();
+  }
+
+  void report_frames() {
+    _frames.enable_report();
+  }
+
+  void report_input_latency() {
+    _input_latency.enable();
+  }
+
+  void report_deferred() {
+    _report_deferred = true;
+  }
+
+  void set_pipelined(bool pipelined) {
+    _view_wrapper.set_pipelined(pipelined);
+  }
+
+  // Draw off screen at this size, printing each frame's timing, without a
+  // saved session so runs start alike.
+  void set_headless(int w, int h) {
+    _headless = true;
+    _view_wrapper.set_offscreen(w, h);
+  }
+
+  // Play script instead of waiting for input, quitting at its end. Shots
+  // are dumped to and compared with the directories given, if any.
+  void set_script(const std::vector<ScriptStep> & script,
+                  const std::string & dump_dir, const std::string & golden_dir) {
+    _script = script;
+    _shots.reset(new ShotRecorder(dump_dir, golden_dir));
+  }
+
+  // Headless runs print each frame's timing; scripted runs note when the
+  // first frame and the first with no box loading were presented, and how
+  // long boxes showed the dots after moves, which is where a slow network
+  // shows up.
+  void presented(const PLView::PresentTiming & timing) {
+    if (_input_latency.is_enabled()) {
+      _input_latency.presented(timing.requested, timing.presented, timing.present_ms);
+    }
+    if (_headless) {
+      printf("frame %u: compose %.2f ms, present %.2f ms, latency %.2f ms%s%s\n",
+             timing.frame, timing.compose_ms, timing.present_ms, timing.latency_ms,
+             timing.precomposed ? ", precomposed" : "", timing.loading ? ", loading" : "");
+    }
+    double now_ms = startup_ms();
+    if (_first_paint_ms < 0) {
+      _first_paint_ms = now_ms;
+    }
+    if (_all_visible_ms < 0 && !timing.loading) {
+      _all_visible_ms = now_ms;
+    }
+    if (timing.loading && _loading_since_ms < 0) {
+      _loading_since_ms = now_ms;
+    } else if (!timing.loading && _loading_since_ms >= 0) {
+      _loading_ms += now_ms - _loading_since_ms;
+      _loading_since_ms = -1;
+    }
+  }
+
+  void report_paint_times() {
+    if (_loading_since_ms >= 0) {
+      _loading_ms += startup_ms() - _loading_since_ms;
+      _loading_since_ms = -1;
+    }
+    printf("first paint %.1f ms, ", _first_paint_ms);
+    if (_all_visible_ms < 0) {
+      printf("all visible never, ");
+    } else {
+      printf("all visible %.1f ms, ", _all_visible_ms);
+    }
+    printf("dots shown %.1f ms\n", _loading_ms);
+  }
+
+  // Takes the script's steps that are due. Each input is pushed as an
+  // event and handled by the loop like a real one, before the next step.
+  // Returns false once the script has finished.
+  bool step_script() {
+    Uint32 now = SDL_GetTicks();
+    while (_next_step < _script.size()) {
+      const ScriptStep & step = _script[_next_step];
+      if (_step_ticks == 0) {
+        _step_ticks = now;
+      }
+      bool input = step.kind == ScriptStep::press || step.kind == ScriptStep::type;
+      SDL_Event event;
+      SDL_zero(event);
+      switch (step.kind) {
+      case ScriptStep::press:
+        event.type = SDL_KEYDOWN;
+        event.key.keysym.sym = step.keycode;
+        break;
+      case ScriptStep::type:
+        event.type = SDL_TEXTINPUT;
+        strncpy(event.text.text, step.text.c_str(), sizeof(event.text.text) - 1);
+        break;
+      case ScriptStep::wait:
+        if (!SDL_TICKS_PASSED(now, _step_ticks + step.ms)) {
+          return true;
+        }
+        break;
+      case ScriptStep::settle:
+      case ScriptStep::shot:
+        if (!_view_wrapper.is_settled()) {
+          if (!SDL_TICKS_PASSED(now, _step_ticks + settle_timeout_ms)) {
+            return true;
+          }
+          warning("script: gave up waiting for the app to settle");
+        }
+        if (step.kind == ScriptStep::shot) {
+          _shots->shoot(_view_wrapper.frame());
+        }
+        break;
+      }
+      _next_step++;
+      _step_ticks = 0;
+      if (input) {
+        if (SDL_PushEvent(&event) != 1) {
+          error("script: couldn't push input");
+        }
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Runs deferred work in whatever is left of the frame.
+  void run_deferred() {
+    TRACE_SPAN("run_deferred");
+    if (!_view_wrapper.has_deferred_work()) {
+      return;
+    }
+    FrameScheduler::Stats stats = _view_wrapper.run_deferred(_frames.ms_left());
+    if (_report_deferred) {
+      fprintf(stderr, "deferred: %u tasks in %.2f ms, %zu waiting\n",
+              stats.ran, stats.ms, stats.backlog);
+    }
+  }
+
+  // Draws the transition's next frame if it is due.
+  void step_transition() {
+    if (!_view_wrapper.animating()) {
+      return;
+    }
+    if (!_frames.is_running()) {
+      _view_wrapper.take_render_stats();
+      _frames.start();
+    }
+    if (_frames.is_frame_due()) {
+      _frames.begin_frame();
+      _view_wrapper.render_frame();
+      _frames.end_frame();
+    }
+    if (!_view_wrapper.animating()) {
+      _view_wrapper.flush_frames();
+      _frames.stop();
+      report_render(_view_wrapper.take_render_stats());
+    }
+  }
+
+  // What the view drew during the transition just ended, if reporting.
+  void report_render(const PLView::RenderStats & render) {
+    if (_frames.is_reporting() && render.presented > 0) {
+      fprintf(stderr, "  %u presented, %u superseded, %u precomposed; latency %.2f ms average,"
+              " %.2f max; compose %.2f ms, present %.2f ms average\n",
+              render.presented, render.superseded, render.precomposed,
+              render.latency_ms_total / render.presented, render.latency_ms_max,
+              render.compose_ms_total / render.presented,
+              render.present_ms_total / render.presented);
+    }
+  }
+
+  // Waits up to timeout_ms for an event. SDL_WaitEventTimeout only blocks
+  // from SDL 2.0.16; before that it polls every 10 ms, more often than the
+  // old fixed 16 ms loop. There, input is polled for here instead, at
+  // active_poll_ms just after input and idle_poll_ms otherwise, sleeping in
+  // between on wake_signal so background work still wakes the loop at once.
+  bool wait_for_event(SDL_Event & event, int timeout_ms) {
+#if SDL_VERSION_ATLEAST(2, 0, 16)
+    return SDL_WaitEventTimeout(&event, timeout_ms) != 0;
+#else
+    Uint32 deadline = SDL_GetTicks() + timeout_ms;
+    for (;;) {
+      if (SDL_PollEvent(&event) != 0) {
+        return true;
+      }
+      Uint32 now = SDL_GetTicks();
+      if (SDL_TICKS_PASSED(now, deadline)) {
+        return false;
+      }
+      bool active = now - _last_input_ticks < active_seconds * 1000;
+      int sleep_ms = std::min(active ? active_poll_ms : idle_poll_ms, (int)(deadline - now));
+      std::unique_lock<std::mutex> lock(wake_mutex);
+      if (!wake_signal.wait_for(lock, std::chrono::milliseconds(sleep_ms), [] { return woken; })) {
+        _wakeups.count(WakeupStats::poll);
+      }
+      woken = false;
+    }
+#endif
+  }
+
+  // Returns false once the app should quit. Wake events need no handling
+  // here; the loop applies whatever background work finished.
+  bool handle_event(const SDL_Event & event) {
+    TRACE_SPAN("handle_event");
+    switch (event.type) {
+    case SDL_QUIT:
+      return false;
+    case SDL_TEXTINPUT:
+      _view_wrapper.search_append(event.text.text);
+      break;
+    case SDL_KEYDOWN:
+      if (_view_wrapper.is_searching()) {
+        handle_search_key(event.key.keysym.sym);
+        break;
+      }
+      switch (event.key.keysym.sym) {
+      case SDLK_LEFT:
+        _view_wrapper.move_left();
+        break;
+      case SDLK_RIGHT:
+        _view_wrapper.move_right();
+        break;
+      case SDLK_SLASH:
+        _view_wrapper.begin_search();
+        break;
+      case SDLK_t:
+        _view_wrapper.toggle_team_filter();
+        break;
+      case SDLK_v:
+        _view_wrapper.toggle_venue_filter();
+        break;
+      case SDLK_m:
+        _view_wrapper.toggle_date_filter(true);
+        break;
+      case SDLK_d:
+        _view_wrapper.toggle_date_filter(false);
+        break;
+      case SDLK_ESCAPE:
+        if (_view_wrapper.is_filtered()) {
+          _view_wrapper.clear_filters();
+        }
+        break;
+      case SDLK_l:
+        if (_input_latency.is_enabled()) {
+          _input_latency.report();
+        }
+        break;
+      case SDLK_q:
+        return false;
+      }
+      break;
+    }
+    return true;
+  }
+
+  // See PLViewWrapper::init_image_loading for the order of cold start.
+  // Returns the exit status: nonzero if a scripted run's shots didn't
+  // match their golden images.
+  int run() {
+    StartupSpan to_first_frame("to first frame");
+    if (_headless || _shots || _input_latency.is_enabled()) {
+      _view_wrapper.on_present([this](const PLView::PresentTiming & timing) { presented(timing); });
+    }
+    _view_wrapper.init_image_loading();
+    if (!_headless) {
+      _view_wrapper.open_saved_session(session_key());
+    }
+    std::future<void> games = std::async(std::launch::async, [this] {
+        StartupSpan span("schedule");
+        if (_season_first_date.empty()) {
+          _view_wrapper.load_games_for_date(_view_wrapper.resume_date(initial_date));
+        } else {
+          _view_wrapper.load_season(_season_first_date, _season_last_date);
+        }
+      });
+    _view_wrapper.start_loading_assets();
+    _view_wrapper.open_window();
+    _view_wrapper.show_saved_frame();
+    _view_wrapper.finish_loading_assets();
+    {
+      StartupSpan span("wait for schedule");
+      games.get();
+    }
+    if (!_push_url.empty()) {
+      _view_wrapper.follow_deltas(_push_url);
+    }
+    _view_wrapper.restore_saved_focus();
     _view_wrapper.create_surfaces();
+    _view_wrapper.free_reusable_surfaces();
     _view_wrapper.render_all();
+    _view_wrapper.flush_frames();
+    to_first_frame.end();
+    print_startup_timeline(std::cerr);
+    _view_wrapper.page_if_near_end();
     
-    SDL_Event event;
+    Uint32 next_checkpoint = SDL_GetTicks() + session_save_seconds * 1000;
     bool is_running = true;
     while (is_running) {
-      while (SDL_PollEvent(&event) != 0) {
-        switch (event.type) {
-        case SDL_QUIT:
-          is_running = false;
-          break;
-        case SDL_KEYDOWN:
-          switch (event.key.keysym.sym) {
-          case SDLK_LEFT:
-            _view_wrapper.move_left();
-            break;
-          case SDLK_RIGHT:
-            _view_wrapper.move_right();
-            break;
-          case SDLK_q:
-            is_running = false;
-            break;
-          }
-          break;
-        }
+      _view_wrapper.apply_refreshed_games();
+      _view_wrapper.apply_pushed_deltas();
+      _view_wrapper.apply_loaded_pages();
+      _view_wrapper.apply_loaded_boxes();
+      step_transition();
+      _view_wrapper.present_composed();
+      run_deferred();
+      if (_shots && !step_script()) {
+        break;
+      }
+      if (SDL_TICKS_PASSED(SDL_GetTicks(), next_checkpoint)) {
+        _view_wrapper.checkpoint_session_later();
+        next_checkpoint = SDL_GetTicks() + session_save_seconds * 1000;
+      }
+
+      // sleep until input, a wake event from background work, or a timer
+      int timeout = std::max(0, (int)(next_checkpoint - SDL_GetTicks()));
+      int retry = _view_wrapper.ms_until_paging_retry();
+      if (retry >= 0) {
+        timeout = std::min(timeout, retry);
+      }
+      int frame = _frames.ms_until_frame();
+      if (frame >= 0) {
+        timeout = std::min(timeout, frame);
+      } else if (_view_wrapper.has_deferred_work()) {
+        timeout = 0;
+      }
+      if (_shots) {
+        timeout = std::min(timeout, script_poll_ms);
       }
-      SDL_Delay(16);
+      SDL_Event event;
+      if (!wait_for_event(event, timeout)) {
+        _wakeups.count(WakeupStats::timer);
+        continue;
+      }
+      if (event.type == wake_event_type) {
+        _wakeups.count(WakeupStats::background);
+      } else {
+        _wakeups.count(WakeupStats::input);
+        _last_input_ticks = SDL_GetTicks();
+      }
+      do {
+        Uint64 dequeued = SDL_GetPerformanceCounter();
+        unsigned changes = _view_wrapper.changes();
+        is_running = handle_event(event) && is_running;
+        if (event.type == SDL_KEYDOWN && _input_latency.is_enabled()
+            && _view_wrapper.changes() != changes) {
+          _input_latency.handled(dequeued);
+        }
+      } while (SDL_PollEvent(&event) != 0);
+    }
+    _view_wrapper.checkpoint_session(true);
+    if (_input_latency.is_enabled()) {
+      _input_latency.report();
+    }
+    if (_shots) {
+      report_paint_times();
+    }
+    if (_shots && !_shots->report(std::cout)) {
+      return 1;
     }
+    return 0;
   }
 };
 
+// Fetch every date in the range concurrently and save the merged catalog,
+// refetching only dates whose schedule changed since the last build.
+static int build_season_index(std::string first_date, std::string last_date) {
+  SeasonIndex index(first_date, last_date, aspect_ratio_string, minimum_width, schedule_url);
+  SeasonIndex::UpdateStats stats = index.update(season_index_threads);
+  printf("%zu games: %d dates fetched, %d not modified, %d failed in %.2f s\n",
+         stats.games, stats.fetched, stats.not_modified, stats.failed, stats.seconds);
+  return stats.failed == 0 ? 0 : 1;
+}
+
+static void usage() {
+  std::cerr << "usage: PhotoList [--season FIRST LAST] [--push URL] [--sports ID,...] [--timeline] [--wakeups] [--frames] [--deferred]" << std::endl
+            << "                 [--latency] [--single-stage] [--headless WxH] [--script FILE [--dump DIR] [--golden DIR]]" << std::endl
+            << "                 [--statsapi ORIGIN] [--trace FILE]" << std::endl
+            << "       PhotoList --build-index FIRST LAST" << std::endl
+            << "  dates are YYYY-MM-DD; URL is a server-sent events or" << std::endl
+            << "  newline-delimited JSON endpoint of per-game changes;" << std::endl
+            << "  each statsapi sportId is a feed, merged by game time;" << std::endl
+            << "  --timeline prints where startup time went;" << std::endl
+            << "  --wakeups prints how often the main loop wakes, and why;" << std::endl
+            << "  --frames prints each transition's frame count and drops;" << std::endl
+            << "  --deferred prints main-thread work put off to between frames;" << std::endl
+            << "  --latency prints key press to screen latency percentiles by" << std::endl
+            << "  stage on exit, or when L is pressed;" << std::endl
+            << "  --single-stage composes and presents frames on the main thread;" << std::endl
+            << "  --headless draws off screen, printing each frame's timing, and" << std::endl
+            << "  needs --script, whose steps are documented in ScriptedRun.hpp;" << std::endl
+            << "  a script's run ends by printing when the first frame, and the" << std::endl
+            << "  first with every photo in, were presented, and for how long" << std::endl
+            << "  any box showed the loading dots;" << std::endl
+            << "  --dump saves the script's shots to DIR and --golden compares" << std::endl
+            << "  them with those in DIR, exiting 1 if any differ;" << std::endl
+            << "  --statsapi fetches schedules from ORIGIN, such as" << std::endl
+            << "  http://127.0.0.1:8125 for tools/statsapi_standin.py;" << std::endl
+            << "  --trace saves a Chrome trace of the session to FILE on exit," << std::endl
+            << "  in builds with PHOTOLIST_TRACE defined" << std::endl;
+  exit(2);
+}
+
 int main(int argc, const char * argv[]) {
-  PLController c;
-  c.run();
-  return 0;
+  if (argc > 1 && strcmp(argv[1], "--build-index") == 0) {
+    if (argc != 4) {
+      usage();
+    }
+    return build_season_index(argv[2], argv[3]);
+  }
+
+  std::string season_first_date;
+  std::string season_last_date;
+  std::string push_url;
+  std::vector<int> sport_ids;
+  bool report_wakeups = false;
+  bool report_frames = false;
+  bool report_deferred = false;
+  bool report_input_latency = false;
+  bool pipelined = true;
+  int headless_w = 0;
+  int headless_h = 0;
+  std::string script_filename;
+  std::string dump_dir;
+  std::string golden_dir;
+  std::string trace_filename;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--season") == 0 && i + 2 < argc) {
+      season_first_date = argv[++i];
+      season_last_date = argv[++i];
+    } else if (strcmp(argv[i], "--push") == 0 && i + 1 < argc) {
+      push_url = argv[++i];
+    } else if (strcmp(argv[i], "--sports") == 0 && i + 1 < argc) {
+      std::stringstream ids(argv[++i]);
+      std::string id;
+      while (std::getline(ids, id, ',')) {
+        int sport_id = atoi(id.c_str());
+        if (sport_id <= 0) {
+          usage();
+        }
+        sport_ids.push_back(sport_id);
+      }
+    } else if (strcmp(argv[i], "--timeline") == 0) {
+      enable_startup_timeline();
+    } else if (strcmp(argv[i], "--wakeups") == 0) {
+      report_wakeups = true;
+    } else if (strcmp(argv[i], "--frames") == 0) {
+      report_frames = true;
+    } else if (strcmp(argv[i], "--deferred") == 0) {
+      report_deferred = true;
+    } else if (strcmp(argv[i], "--latency") == 0) {
+      report_input_latency = true;
+    } else if (strcmp(argv[i], "--single-stage") == 0) {
+      pipelined = false;
+    } else if (strcmp(argv[i], "--headless") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &headless_w, &headless_h) != 2
+          || headless_w <= 0 || headless_h <= 0) {
+        usage();
+      }
+    } else if (strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+      script_filename = argv[++i];
+    } else if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+      dump_dir = argv[++i];
+    } else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+      golden_dir = argv[++i];
+    } else if (strcmp(argv[i], "--statsapi") == 0 && i + 1 < argc) {
+      statsapi_origin = argv[++i];
+    } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+      trace_filename = argv[++i];
+    } else {
+      usage();
+    }
+  }
+
+  if (script_filename.empty() && (headless_w > 0 || !dump_dir.empty() || !golden_dir.empty())) {
+    usage();
+  }
+  if (!trace_filename.empty() && !tracing_compiled()) {
+    error("--trace needs a build with PHOTOLIST_TRACE defined, such as PhotoList-trace");
+  }
+  if (sport_ids.empty()) {
+    sport_ids.push_back(default_sport_id);
+  }
+  TRACE_THREAD_NAME("main");
+  PLController c(sport_ids);
+  if (!season_first_date.empty()) {
+    c.set_season(season_first_date, season_last_date);
+  }
+  if (!push_url.empty()) {
+    c.set_push_url(push_url);
+  }
+  if (report_wakeups) {
+    c.report_wakeups();
+  }
+  if (report_frames) {
+    c.report_frames();
+  }
+  if (report_deferred) {
+    c.report_deferred();
+  }
+  if (report_input_latency) {
+    c.report_input_latency();
+  }
+  c.set_pipelined(pipelined);
+  if (headless_w > 0) {
+    c.set_headless(headless_w, headless_h);
+  }
+  if (!script_filename.empty()) {
+    c.set_script(read_script(script_filename), dump_dir, golden_dir);
+  }
+  int status = c.run();
+  if (!trace_filename.empty() && !write_trace(trace_filename)) {
+    warning(("couldn't write trace to " + trace_filename).c_str());
+  }
+  return status;
 }
@@ -6,3 +6,7 @@ void error(const char * message) {
   std::cerr << "PhotoList error: " << message << std::endl;
   exit(1);
 }
+
+void warning(const char * message) {
+  std::cerr << "PhotoList warning: " << message << std::endl;
+}
@@ -11,5 +11,6 @@ protected:
 };
 
 void error(const char * message);
+void warning(const char * message);
 
 #endif
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+#
+#  replay_deltas.py
+#  PhotoList
+#
+#  Stand-in for the push endpoint used by `PhotoList --push URL`. Serves a
+#  recorded delta stream, sending each message after the delay it was
+#  recorded with, as server-sent events or newline-delimited JSON.
+#
+#    tools/replay_deltas.py [--port 8124] [--speed 1.0] [--loop] [RECORDING]
+#    PhotoList --push http://127.0.0.1:8124/deltas          (SSE)
+#    PhotoList --push http://127.0.0.1:8124/deltas?ndjson   (NDJSON)
+#
+#  A recording has one line per message:
+#    {"after_ms": 1500, "message": {"date": ..., "game": {...}}}
+#  where after_ms is the time since the previous message. Lines starting with
+#  # are comments. `record URL OUT` captures a live NDJSON endpoint in this
+#  format.
+
+import argparse
+import json
+import os
+import sys
+import time
+import urllib.request
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+DEFAULT_RECORDING = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                 'recorded-deltas.ndjson')
+
+
+def read_recording(path):
+    entries = []
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if line and not line.startswith('#'):
+                entry = json.loads(line)
+                entries.append((entry.get('after_ms', 0), entry['message']))
+    return entries
+
+
+def make_handler(entries, speed, loop):
+    class Handler(BaseHTTPRequestHandler):
+        protocol_version = 'HTTP/1.0'  # the body ends when the connection closes
+
+        def do_GET(self):
+            if not self.path.startswith('/deltas'):
+                self.send_error(404)
+                return
+            ndjson = 'ndjson' in self.path
+            self.send_response(200)
+            self.send_header('Content-Type',
+                             'application/x-ndjson' if ndjson else 'text/event-stream')
+            self.send_header('Cache-Control', 'no-cache')
+            self.end_headers()
+            try:
+                while True:
+                    for after_ms, message in entries:
+                        time.sleep(after_ms / 1000.0 / speed)
+                        text = json.dumps(message, separators=(',', ':'))
+                        if ndjson:
+                            self.wfile.write((text + '\n').encode())
+                        else:
+                            self.wfile.write(('data: ' + text + '\n\n').encode())
+                        self.wfile.flush()
+                    if not loop:
+                        break
+            except (BrokenPipeError, ConnectionResetError):
+                pass
+
+        def log_message(self, format, *args):
+            sys.stderr.write('replay_deltas: ' + (format % args) + '\n')
+
+    return Handler
+
+
+def record(url, out_path):
+    last = time.monotonic()
+    with urllib.request.urlopen(url) as response, open(out_path, 'w') as out:
+        for line in response:
+            line = line.strip()
+            if not line:
+                continue
+            now = time.monotonic()
+            entry = {'after_ms': int((now - last) * 1000), 'message': json.loads(line)}
+            out.write(json.dumps(entry) + '\n')
+            out.flush()
+            last = now
+
+
+def main():
+    if len(sys.argv) == 4 and sys.argv[1] == 'record':
+        record(sys.argv[2], sys.argv[3])
+        return
+    parser = argparse.ArgumentParser(description='Replay a recorded delta stream.')
+    parser.add_argument('recording', nargs='?', default=DEFAULT_RECORDING)
+    parser.add_argument('--port', type=int, default=8124)
+    parser.add_argument('--speed', type=float, default=1.0,
+                        help='replay this many times faster than recorded')
+    parser.add_argument('--loop', action='store_true',
+                        help='start over at the end instead of closing the stream')
+    args = parser.parse_args()
+
+    entries = read_recording(args.recording)
+    server = ThreadingHTTPServer(('127.0.0.1', args.port),
+                                 make_handler(entries, args.speed, args.loop))
+    print('replaying %d messages on http://127.0.0.1:%d/deltas' % (len(entries), args.port))
+    server.serve_forever()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,581 @@
+#!/usr/bin/env python3
+#
+#  statsapi_standin.py
+#  PhotoList
+#
+#  Stand-in for statsapi and the image CDN, so PhotoList can be run and
+#  measured offline and repeatably, with schedules of any size.
+#
+#    tools/statsapi_standin.py [--port 8125] [--games N] [--recorded DIR]
+#    PhotoList --statsapi http://127.0.0.1:8125
+#
+#  Schedules are served from DIR/DATE-SPORTID.json when recorded there, with
+#  each photo cut's src pointed back at the stand-in, and otherwise made up:
+#  N games a date, each with a photo in two aspect ratios and seven widths.
+#  Either way they carry an ETag and answer If-None-Match with 304, as
+#  statsapi does. Photos are synthetic JPEGs of the size in their URL,
+#  /cuts/WxH/NAME.jpg, with NAME choosing among --distinct-photos looks.
+#
+#  `generate DIR` writes a synthetic schedule and its photos to DIR
+#  instead, for serving from anywhere or for recording:
+#
+#    tools/statsapi_standin.py generate --games 1000 --date 2018-06-10 OUT
+#
+#  --network PROFILE makes every connection behave like one over a worse
+#  link: each response waits a round trip, give or take the jitter, a new
+#  connection waits one more for its handshake, bodies are paced to the
+#  bandwidth, and now and then a stall holds one up as a lost packet would.
+#  The profiles are in NETWORK_PROFILES, and --latency, --jitter,
+#  --bandwidth, --stalls and --stall-ms override their parts. Links are
+#  shaped separately, so connections in parallel each get the bandwidth.
+#
+#  `profiles -- COMMAND...` runs COMMAND once under each profile, with
+#  --statsapi pointing it at a stand-in shaped that way, and tabulates the
+#  times a scripted PhotoList run prints: first paint, when the first frame
+#  went up with the dots in boxes still loading; all visible, the first
+#  frame with every box's photo in; and dots shown, how long boxes showed
+#  the dots in all:
+#
+#    tools/statsapi_standin.py profiles -- \
+#        ./PhotoList --headless 960x540 --script bench/scroll.script
+#
+#  The JPEGs are written by the small baseline encoder below rather than
+#  an imaging library. Their coefficients are made up directly, with
+#  photo-like amounts of detail, so they cost about as much to decode as
+#  real photos of the same size.
+
+import argparse
+import datetime
+import hashlib
+import json
+import os
+import random
+import re
+import subprocess
+import sys
+import threading
+import time
+from collections import namedtuple
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, urlparse
+
+CUT_WIDTHS = [209, 320, 480, 640, 960, 1280, 1920]
+ASPECT_RATIOS = [('16:9', 16, 9), ('4:3', 4, 3)]
+
+
+# JPEG
+
+# One quantization table for every component, in zigzag order, coarser
+# with frequency.
+QUANT = [4 + k // 4 for k in range(64)]
+
+# Huffman tables with every code the same length, which any decoder reads
+# but needs no tuning: 4 bits for the 12 DC sizes and 8 bits for the 162
+# AC run/size symbols.
+DC_SYMBOLS = list(range(12))
+AC_SYMBOLS = [0x00, 0xf0] + [(run << 4) | size for run in range(16) for size in range(1, 11)]
+DC_CODES = {symbol: (i, 4) for i, symbol in enumerate(DC_SYMBOLS)}
+AC_CODES = {symbol: (i, 8) for i, symbol in enumerate(AC_SYMBOLS)}
+
+
+class BitWriter:
+    def __init__(self):
+        self.out = bytearray()
+        self.bits = 0
+        self.n = 0
+
+    def write(self, code, length):
+        self.bits = (self.bits << length) | code
+        self.n += length
+        while self.n >= 8:
+            self.n -= 8
+            byte = (self.bits >> self.n) & 0xff
+            self.out.append(byte)
+            if byte == 0xff:
+                self.out.append(0)  # stuffed, so it isn't read as a marker
+        self.bits &= (1 << self.n) - 1
+
+    def flush(self):
+        if self.n:
+            self.write((1 << (8 - self.n)) - 1, 8 - self.n)
+
+
+def write_dc(writer, diff):
+    size = abs(diff).bit_length()
+    writer.write(*DC_CODES[size])
+    if size:
+        writer.write(diff if diff > 0 else diff + (1 << size) - 1, size)
+
+
+def encode_ac(coefficients):
+    """A block's AC coefficients, in zigzag order, as one code and its
+    length in bits, before stuffing."""
+    code = 0
+    length = 0
+
+    def append(value, size):
+        nonlocal code, length
+        code = (code << size) | value
+        length += size
+
+    run = 0
+    last = max([k for k in range(1, 64) if coefficients[k]] or [0])
+    for k in range(1, last + 1):
+        value = coefficients[k]
+        if value == 0:
+            run += 1
+            continue
+        while run > 15:
+            append(*AC_CODES[0xf0])
+            run -= 16
+        size = abs(value).bit_length()
+        append(*AC_CODES[(run << 4) | size])
+        append(value if value > 0 else value + (1 << size) - 1, size)
+        run = 0
+    if last < 63:
+        append(*AC_CODES[0x00])
+    return code, length
+
+
+def segment(marker, payload):
+    return bytes([0xff, marker]) + (len(payload) + 2).to_bytes(2, 'big') + payload
+
+
+def huffman_table(table_class, symbols, length):
+    counts = [0] * 16
+    counts[length - 1] = len(symbols)
+    return bytes([table_class << 4]) + bytes(counts) + bytes(symbols)
+
+
+def synthetic_jpeg(width, height, seed):
+    """A width x height baseline JPEG, 4:2:0, of a soft diagonal gradient in
+    a color picked by seed with random detail on top."""
+    rng = random.Random(seed)
+    cb_level = rng.randint(-60, 60)
+    cr_level = rng.randint(-60, 60)
+    band = rng.randint(3, 9)
+
+    # Detail is drawn from a pool of blocks encoded once; which block goes
+    # where is still random, so no pattern shows.
+    def detail_pool(detail):
+        pool = []
+        for _ in range(127):
+            coefficients = [0] * 64
+            for k in range(1, 28):
+                if rng.random() < detail * (1 - k / 28):
+                    magnitude = rng.randint(1, max(1, 10 - k // 3))
+                    coefficients[k] = magnitude if rng.random() < 0.5 else -magnitude
+            pool.append(encode_ac(coefficients))
+        return pool
+
+    luma_detail = detail_pool(0.55)
+    chroma_detail = detail_pool(0.2)
+    writer = BitWriter()
+    previous_dc = [0, 0, 0]
+
+    def write_block(component, level, pool):
+        dc = round(level * 8 / QUANT[0])
+        write_dc(writer, dc - previous_dc[component])
+        previous_dc[component] = dc
+        writer.write(*pool[rng.randrange(len(pool))])
+
+    mcus_x = (width + 15) // 16
+    mcus_y = (height + 15) // 16
+    for my in range(mcus_y):
+        for mx in range(mcus_x):
+            for by, bx in ((0, 0), (0, 1), (1, 0), (1, 1)):
+                x = (mx * 2 + bx) / (mcus_x * 2)
+                y = (my * 2 + by) / (mcus_y * 2)
+                luma = 110 * (x + y) / 2 - 40 + 25 * ((int((x + y) * band)) % 2)
+                write_block(0, luma, luma_detail)
+            write_block(1, cb_level * (0.6 + 0.4 * (mx / mcus_x)), chroma_detail)
+            write_block(2, cr_level * (0.6 + 0.4 * (my / mcus_y)), chroma_detail)
+    writer.flush()
+
+    jfif = b'JFIF\x00\x01\x01\x00\x00\x01\x00\x01\x00\x00'
+    frame = bytes([8]) + height.to_bytes(2, 'big') + width.to_bytes(2, 'big') + bytes(
+        [3, 1, 0x22, 0, 2, 0x11, 0, 3, 0x11, 0])
+    scan = bytes([3, 1, 0x00, 2, 0x00, 3, 0x00, 0, 63, 0])
+    return (b'\xff\xd8'
+            + segment(0xe0, jfif)
+            + segment(0xdb, bytes([0]) + bytes(QUANT))
+            + segment(0xc0, frame)
+            + segment(0xc4, huffman_table(0, DC_SYMBOLS, 4) + huffman_table(1, AC_SYMBOLS, 8))
+            + segment(0xda, scan)
+            + bytes(writer.out)
+            + b'\xff\xd9')
+
+
+# Schedules
+
+def cut_path(width, height, name):
+    return '/cuts/%dx%d/%s.jpg' % (width, height, name)
+
+
+def synthetic_game(date, sport_id, n, origin, distinct):
+    # unique across dates and sports, for up to a million games a date
+    day = datetime.date.fromisoformat(date).toordinal() % 100000
+    game_pk = (day * 100 + sport_id % 100) * 1000000 + n
+    cuts = []
+    for aspect, aw, ah in ASPECT_RATIOS:
+        for width in CUT_WIDTHS:
+            height = width * ah // aw
+            cuts.append({'aspectRatio': aspect, 'width': width, 'height': height,
+                         'src': origin + cut_path(width, height, 'p%d' % (n % distinct))})
+    return {
+        'gamePk': game_pk,
+        'gameType': 'R',
+        'season': date[:4],
+        'gameDate': '%sT%02d:%02d:00Z' % (date, 16 + n * 7 // 60 % 8, n * 7 % 60),
+        'officialDate': date,
+        'status': {'abstractGameState': 'Final', 'detailedState': 'Final'},
+        'teams': {
+            'away': {'score': n % 9, 'team': {'id': 100 + n % 30, 'name': 'Team %d' % (n % 30)}},
+            'home': {'score': (n + 3) % 9,
+                     'team': {'id': 100 + (n + 7) % 30, 'name': 'Team %d' % ((n + 7) % 30)}},
+        },
+        'venue': {'id': (n + 7) % 30, 'name': 'Park %d' % ((n + 7) % 30)},
+        'decisions': {
+            'winner': {'id': n % 97, 'fullName': 'Pitcher %d' % (n % 97)},
+            'loser': {'id': (n + 13) % 97, 'fullName': 'Pitcher %d' % ((n + 13) % 97)},
+        },
+        'content': {'editorial': {'recap': {'mlb': {
+            'headline': 'Team %d rallies past Team %d in game %d' % (n % 30, (n + 7) % 30, n),
+            'subhead': 'Slugger %d drives in three as the home side takes the series opener'
+                       % (n % 97),
+            'image': {'title': 'Recap %d' % game_pk, 'cuts': cuts},
+        }}}},
+    }
+
+
+def synthetic_schedule(date, sport_id, games, origin, distinct):
+    """The schedule's JSON text, encoded a game at a time so that a hundred
+    thousand games don't need the memory of them all as objects."""
+    body = bytearray(b'{"totalGames":%d,"dates":[{"date":"%s","totalGames":%d,"games":['
+                     % (games, date.encode(), games))
+    for n in range(games):
+        if n:
+            body += b','
+        body += json.dumps(synthetic_game(date, sport_id, n, origin, distinct),
+                           separators=(',', ':')).encode()
+    body += b']}]}'
+    return bytes(body)
+
+
+def point_cuts_at(schedule, origin):
+    """Rewrites a recorded schedule's photo URLs to the stand-in's, keeping
+    each cut's size and the file name."""
+    for date in schedule.get('dates', []):
+        for game in date.get('games', []):
+            image = game.get('content', {}).get('editorial', {}).get('recap', {}) \
+                        .get('mlb', {}).get('image', {})
+            for cut in image.get('cuts', []):
+                name = os.path.splitext(os.path.basename(urlparse(cut['src']).path))[0]
+                cut['src'] = origin + cut_path(cut['width'], cut['height'], name)
+    return schedule
+
+
+def photo_seed(name, distinct):
+    return int(hashlib.sha1(name.encode()).hexdigest(), 16) % distinct
+
+
+# Network
+
+# latency_ms is the round trip; a stall, with stall_chance per packet's
+# worth of body, holds the body up for stall_ms, about a retransmission.
+Link = namedtuple('Link', 'latency_ms jitter_ms kbit_s stall_chance stall_ms')
+
+NETWORK_PROFILES = {
+    'lan': Link(latency_ms=1, jitter_ms=0, kbit_s=0, stall_chance=0, stall_ms=0),
+    'broadband': Link(latency_ms=30, jitter_ms=5, kbit_s=50000, stall_chance=0, stall_ms=0),
+    'venue-wifi': Link(latency_ms=80, jitter_ms=40, kbit_s=8000, stall_chance=0.002, stall_ms=300),
+    'crowded-wifi': Link(latency_ms=300, jitter_ms=150, kbit_s=1000, stall_chance=0.01, stall_ms=1000),
+    'cellular-edge': Link(latency_ms=600, jitter_ms=200, kbit_s=250, stall_chance=0.02, stall_ms=2000),
+}
+
+PACKET = 1460  # bytes paced and possibly stalled at a time
+
+
+class ShapedConnection:
+    """One connection's view of a link, with its own random jitter and
+    stalls so that runs with the same seed see the same network."""
+
+    def __init__(self, link, seed):
+        self.link = link
+        self.random = random.Random(seed)
+        self.handshaken = False
+
+    def sleep_ms(self, ms):
+        if ms > 0:
+            time.sleep(ms / 1000.0)
+
+    def round_trip(self):
+        """Waits out the request's trip there and the response's back,
+        and the handshake's before the connection's first request."""
+        trips = 1 if self.handshaken else 2
+        self.handshaken = True
+        for _ in range(trips):
+            jitter = self.random.uniform(-self.link.jitter_ms, self.link.jitter_ms)
+            self.sleep_ms(self.link.latency_ms + jitter)
+
+    def send(self, wfile, body):
+        """Writes body at the link's bandwidth, stalling now and then."""
+        start = time.monotonic()
+        stalled_ms = 0
+        for offset in range(0, len(body), PACKET):
+            if self.link.stall_chance and self.random.random() < self.link.stall_chance:
+                self.sleep_ms(self.link.stall_ms)
+                stalled_ms += self.link.stall_ms
+            if self.link.kbit_s:
+                due = start + (offset * 8 / self.link.kbit_s + stalled_ms) / 1000.0
+                self.sleep_ms((due - time.monotonic()) * 1000)
+            wfile.write(body[offset:offset + PACKET])
+        wfile.flush()
+
+
+def chosen_link(args):
+    """The --network profile with any parts overridden, or None if the
+    network isn't to be shaped."""
+    overrides = {'latency_ms': args.latency, 'jitter_ms': args.jitter, 'kbit_s': args.bandwidth,
+                 'stall_chance': args.stalls, 'stall_ms': args.stall_ms}
+    overrides = {k: v for k, v in overrides.items() if v is not None}
+    if not args.network and not overrides:
+        return None
+    return NETWORK_PROFILES[args.network or 'lan']._replace(**overrides)
+
+
+# Server
+
+class Standin:
+    def __init__(self, games, recorded_dir, distinct):
+        self.games = games
+        self.recorded_dir = recorded_dir
+        self.distinct = distinct
+        self.lock = threading.Lock()
+        self.schedules = {}  # (date, sport_id, origin) -> (body, etag)
+        self.photos = {}     # (width, height, seed) -> jpeg
+
+    def schedule(self, date, sport_id, origin):
+        key = (date, sport_id, origin)
+        with self.lock:
+            if key in self.schedules:
+                return self.schedules[key]
+        recorded = os.path.join(self.recorded_dir or '', '%s-%d.json' % (date, sport_id))
+        if self.recorded_dir and os.path.exists(recorded):
+            with open(recorded) as f:
+                schedule = point_cuts_at(json.load(f), origin)
+            body = json.dumps(schedule, separators=(',', ':')).encode()
+        else:
+            body = synthetic_schedule(date, sport_id, self.games, origin, self.distinct)
+        entry = (body, '"%s"' % hashlib.sha1(body).hexdigest()[:16])
+        with self.lock:
+            self.schedules[key] = entry
+        return entry
+
+    def photo(self, width, height, name):
+        key = (width, height, photo_seed(name, self.distinct))
+        with self.lock:
+            if key in self.photos:
+                return self.photos[key]
+        jpeg = synthetic_jpeg(width, height, key[2])
+        with self.lock:
+            self.photos[key] = jpeg
+        return jpeg
+
+
+def make_handler(standin, link, seed):
+    """link is None for an unshaped server."""
+    connections = iter(range(sys.maxsize))
+    connections_lock = threading.Lock()
+
+    class Handler(BaseHTTPRequestHandler):
+        protocol_version = 'HTTP/1.1'
+
+        def setup(self):
+            BaseHTTPRequestHandler.setup(self)
+            self.shaped = None
+            if link is not None:
+                with connections_lock:
+                    n = next(connections)
+                self.shaped = ShapedConnection(link, seed * 1000003 + n)
+
+        def do_GET(self):
+            if self.shaped:
+                self.shaped.round_trip()
+            url = urlparse(self.path)
+            if url.path == '/api/v1/schedule':
+                self.get_schedule(parse_qs(url.query))
+            elif url.path.startswith('/cuts/'):
+                self.get_photo(url.path)
+            else:
+                self.send_error(404)
+
+        def get_schedule(self, query):
+            date = query.get('date', [''])[0]
+            try:
+                datetime.date.fromisoformat(date)
+                sport_id = int(query.get('sportId', ['1'])[0])
+            except ValueError:
+                self.send_error(400)
+                return
+            origin = 'http://' + self.headers.get('Host', '127.0.0.1:%d' % self.server.server_port)
+            body, etag = standin.schedule(date, sport_id, origin)
+            if self.headers.get('If-None-Match') == etag:
+                self.send_response(304)
+                self.send_header('ETag', etag)
+                self.send_header('Content-Length', '0')
+                self.end_headers()
+                return
+            self.send_body(body, 'application/json', {'ETag': etag})
+
+        def get_photo(self, path):
+            parts = path.split('/')
+            try:
+                width, height = (int(x) for x in parts[2].split('x'))
+                name = os.path.splitext(parts[3])[0]
+            except (IndexError, ValueError):
+                self.send_error(404)
+                return
+            if not (0 < width <= 8192 and 0 < height <= 8192):
+                self.send_error(404)
+                return
+            self.send_body(standin.photo(width, height, name), 'image/jpeg', {})
+
+        def send_body(self, body, content_type, headers):
+            self.send_response(200)
+            self.send_header('Content-Type', content_type)
+            self.send_header('Content-Length', str(len(body)))
+            for name, value in headers.items():
+                self.send_header(name, value)
+            self.end_headers()
+            try:
+                if self.shaped:
+                    self.shaped.send(self.wfile, body)
+                else:
+                    self.wfile.write(body)
+            except (BrokenPipeError, ConnectionResetError):
+                pass
+
+        def log_message(self, format, *args):
+            if self.server.verbose:
+                sys.stderr.write('statsapi_standin: ' + (format % args) + '\n')
+
+    return Handler
+
+
+def generate(args):
+    """Writes DIR/DATE-1.json and the photos it refers to under DIR/cuts,
+    with srcs under --origin."""
+    os.makedirs(args.dir, exist_ok=True)
+    with open(os.path.join(args.dir, '%s-1.json' % args.date), 'wb') as f:
+        f.write(synthetic_schedule(args.date, 1, args.games, args.origin, args.distinct_photos))
+    photos = 0
+    for _, aw, ah in ASPECT_RATIOS:
+        for width in CUT_WIDTHS:
+            for k in range(min(args.games, args.distinct_photos)):
+                name = 'p%d' % k
+                out = os.path.join(args.dir, cut_path(width, width * ah // aw, name).lstrip('/'))
+                os.makedirs(os.path.dirname(out), exist_ok=True)
+                with open(out, 'wb') as f:
+                    f.write(synthetic_jpeg(width, width * ah // aw,
+                                           photo_seed(name, args.distinct_photos)))
+                photos += 1
+    print('%d games and %d photos in %s' % (args.games, photos, args.dir))
+
+
+def serve(standin, link, args, port):
+    server = ThreadingHTTPServer(('127.0.0.1', port), make_handler(standin, link, args.seed))
+    server.daemon_threads = True
+    server.verbose = args.verbose
+    return server
+
+
+def compare_profiles(args):
+    """Runs the command once under each profile against a shaped stand-in
+    on a free port, and prints the times its scripted run reported."""
+    command = args.command_line
+    if command[:1] == ['--']:
+        command = command[1:]
+    if not command:
+        sys.exit('statsapi_standin: profiles needs a command to run')
+    names = args.profiles.split(',') if args.profiles else list(NETWORK_PROFILES)
+    for name in names:
+        if name not in NETWORK_PROFILES:
+            sys.exit('statsapi_standin: no network profile %s' % name)
+    standin = Standin(args.games, args.recorded, args.distinct_photos)
+    print('%-14s %7s %7s %7s %15s %15s %15s' % ('profile', 'rtt ms', 'kbit/s', 'stalls',
+                                                'first paint ms', 'all visible ms', 'dots shown ms'))
+    for name in names:
+        link = NETWORK_PROFILES[name]
+        server = serve(standin, link, args, 0)
+        threading.Thread(target=server.serve_forever, daemon=True).start()
+        origin = 'http://127.0.0.1:%d' % server.server_port
+        run = subprocess.run(command + ['--statsapi', origin], stdout=subprocess.PIPE,
+                             stderr=None if args.verbose else subprocess.DEVNULL,
+                             universal_newlines=True)
+        server.shutdown()
+        server.server_close()
+        times = re.search(r'first paint ([\d.]+) ms, all visible (?:([\d.]+) ms|never), '
+                          r'dots shown ([\d.]+) ms', run.stdout)
+        if times:
+            first_paint, all_visible, dots = times.group(1), times.group(2) or 'never', times.group(3)
+        else:
+            first_paint, all_visible, dots = '-', '-', '-'
+        print('%-14s %7d %7s %7g %15s %15s %15s%s' % (
+            name, link.latency_ms, link.kbit_s or '-', link.stall_chance,
+            first_paint, all_visible, dots,
+            '' if run.returncode == 0 else '  (exit %d)' % run.returncode))
+        sys.stdout.flush()
+
+
+def main():
+    synthetic = argparse.ArgumentParser(add_help=False)
+    synthetic.add_argument('--games', type=int, default=15,
+                           help='games a date in synthetic schedules')
+    synthetic.add_argument('--distinct-photos', type=int, default=16,
+                           help='different photos to cycle through, of each size')
+    parser = argparse.ArgumentParser(description='Stand in for statsapi and its image CDN.',
+                                     parents=[synthetic])
+    subcommands = parser.add_subparsers(dest='command')
+    generate_parser = subcommands.add_parser('generate', parents=[synthetic],
+                                             help='write a synthetic schedule and its photos')
+    generate_parser.add_argument('dir')
+    generate_parser.add_argument('--date', default='2018-06-10')
+    generate_parser.add_argument('--origin', default='http://127.0.0.1:8125',
+                                 help='where the photos will be served from')
+    profiles_parser = subcommands.add_parser('profiles', parents=[synthetic],
+                                             help='time a scripted run under each network profile')
+    profiles_parser.add_argument('--profiles', metavar='NAME,...',
+                                 help='profiles to run, of %s' % ', '.join(NETWORK_PROFILES))
+    profiles_parser.add_argument('command_line', nargs=argparse.REMAINDER)
+    parser.add_argument('--port', type=int, default=8125)
+    parser.add_argument('--network', choices=list(NETWORK_PROFILES),
+                        help='shape every connection like this')
+    parser.add_argument('--latency', type=float, metavar='MS', help='round trip')
+    parser.add_argument('--jitter', type=float, metavar='MS', help='round trips vary by up to this')
+    parser.add_argument('--bandwidth', type=float, metavar='KBIT', help='per connection, in kbit/s')
+    parser.add_argument('--stalls', type=float, metavar='CHANCE', help='of a stall per packet')
+    parser.add_argument('--stall-ms', type=float, metavar='MS', help='how long a stall lasts')
+    parser.add_argument('--seed', type=int, default=1, help='for jitter and stalls')
+    parser.add_argument('--recorded', metavar='DIR',
+                        help='serve DIR/DATE-SPORTID.json where present')
+    parser.add_argument('--verbose', action='store_true', help='log each request')
+    args = parser.parse_args()
+
+    if args.command == 'generate':
+        generate(args)
+        return
+    if args.command == 'profiles':
+        compare_profiles(args)
+        return
+    standin = Standin(args.games, args.recorded, args.distinct_photos)
+    link = chosen_link(args)
+    server = serve(standin, link, args, args.port)
+    print('standing in for statsapi on http://127.0.0.1:%d, %d games a date%s'
+          % (args.port, args.games, ', shaped as %s' % (link,) if link else ''))
+    sys.stdout.flush()
+    server.serve_forever()
+
+
+if __name__ == '__main__':
+    main()